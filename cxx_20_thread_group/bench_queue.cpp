@@ -0,0 +1,159 @@
+#include "concurrent_bounded_queue.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <latch>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+// What concurrent_bounded_queue used to be, plus the missing bound.
+template<typename Type, std::uint64_t QueueDepth>
+class locked_bounded_queue
+{
+public:
+    auto enqueue(Type value) -> void
+    {
+        auto lock = std::unique_lock {mtx};
+        not_full.wait(lock, [this] { return items.size() < QueueDepth; });
+        items.push(std::move(value));
+        lock.unlock();
+        not_empty.notify_one();
+    }
+
+    auto dequeue() -> Type
+    {
+        auto lock = std::unique_lock {mtx};
+        not_empty.wait(lock, [this] { return !items.empty(); });
+        auto tmp = std::move(items.front());
+        items.pop();
+        lock.unlock();
+        not_full.notify_one();
+        return tmp;
+    }
+
+private:
+    std::mutex mtx;
+    std::condition_variable not_full;
+    std::condition_variable not_empty;
+    std::queue<Type> items;
+};
+
+// Blocking variant: every call succeeds eventually.
+struct blocking
+{
+    static auto push(auto& q, std::uint64_t v) -> void { q.enqueue(v); }
+    static auto pop(auto& q) -> std::uint64_t { return q.dequeue(); }
+};
+
+// Non-blocking variant: spin on try_ until it works.
+struct spinning
+{
+    static auto push(auto& q, std::uint64_t v) -> void
+    {
+        while (!q.try_enqueue(v))
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    static auto pop(auto& q) -> std::uint64_t
+    {
+        while (true)
+        {
+            if (auto v = q.try_dequeue(); v)
+            {
+                return *v;
+            }
+            std::this_thread::yield();
+        }
+    }
+};
+
+template<typename Queue, typename Policy>
+auto run(char const* name, unsigned producers, unsigned consumers, std::uint64_t items) -> void
+{
+    auto queue = std::make_unique<Queue>();
+    auto start = std::latch {producers + consumers + 1};
+    auto sums  = std::vector<std::uint64_t>(consumers);
+
+    auto threads = std::vector<std::jthread> {};
+    for (auto p = 0U; p < producers; ++p)
+    {
+        auto const count = items / producers + (p < items % producers ? 1 : 0);
+        threads.emplace_back([&, count] {
+            start.arrive_and_wait();
+            for (std::uint64_t i = 1; i <= count; ++i)
+            {
+                Policy::push(*queue, i);
+            }
+        });
+    }
+
+    for (auto c = 0U; c < consumers; ++c)
+    {
+        auto const count = items / consumers + (c < items % consumers ? 1 : 0);
+        threads.emplace_back([&, c, count] {
+            start.arrive_and_wait();
+            auto sum = std::uint64_t {0};
+            for (std::uint64_t i = 0; i < count; ++i)
+            {
+                sum += Policy::pop(*queue);
+            }
+            sums[c] = sum;
+        });
+    }
+
+    start.arrive_and_wait();
+    auto const t0 = std::chrono::steady_clock::now();
+    threads.clear();
+    auto const t1 = std::chrono::steady_clock::now();
+
+    auto total = std::uint64_t {0};
+    for (auto s : sums)
+    {
+        total += s;
+    }
+
+    auto expected = std::uint64_t {0};
+    for (auto p = 0U; p < producers; ++p)
+    {
+        auto const count = items / producers + (p < items % producers ? 1 : 0);
+        expected += count * (count + 1) / 2;
+    }
+
+    auto const seconds = std::chrono::duration<double>(t1 - t0).count();
+    std::printf("%-22s %2up %2uc %10.2f Mops/s%s\n", name, producers, consumers, items / seconds / 1e6,
+                total == expected ? "" : "  CHECKSUM MISMATCH");
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) -> int
+{
+    auto const hw      = std::max(2U, std::thread::hardware_concurrency());
+    auto const threads = argc > 1 ? static_cast<unsigned>(std::stoul(argv[1])) : hw;
+    auto const items   = argc > 2 ? std::stoull(argv[2]) : std::uint64_t {2'000'000};
+
+    constexpr auto depth = std::uint64_t {1024};
+    using ring           = concurrent_bounded_queue<std::uint64_t, depth>;
+    using locked         = locked_bounded_queue<std::uint64_t, depth>;
+
+    // Same number of producers and consumers, from 1:1 up to threads in total.
+    for (auto n = 1U; n <= std::max(1U, threads / 2); n *= 2)
+    {
+        run<ring, blocking>("ring enqueue/dequeue", n, n, items);
+        run<ring, spinning>("ring try_ + yield", n, n, items);
+        run<locked, blocking>("mutex + condvar", n, n, items);
+    }
+
+    return EXIT_SUCCESS;
+}
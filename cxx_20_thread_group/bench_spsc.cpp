@@ -0,0 +1,133 @@
+#include "concurrent_bounded_queue.hpp"
+#include "spsc_queue.hpp"
+
+#include <emmintrin.h>  // for _mm_pause
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+using clock_type = std::chrono::steady_clock;
+
+auto now_ns() noexcept -> std::int64_t { return clock_type::now().time_since_epoch() / std::chrono::nanoseconds {1}; }
+
+// Busy polling like an audio callback would, but give the CPU away now and
+// then so the benchmark also finishes on a single core.
+template<typename TryOnce>
+auto poll(TryOnce&& try_once) -> void
+{
+    for (auto spins = 0; !try_once(); ++spins)
+    {
+        if (spins % 1024 == 1023)
+        {
+            std::this_thread::yield();
+        }
+        else
+        {
+            _mm_pause();
+        }
+    }
+}
+
+// Producer sends a timestamp every interval, the consumer records how long
+// each one took to arrive.
+template<typename Send, typename Receive>
+auto measure(char const* name, std::size_t messages, std::chrono::nanoseconds interval, Send send, Receive receive)
+    -> void
+{
+    auto latencies = std::vector<std::int64_t>(messages);
+
+    auto consumer = std::jthread {[&] {
+        for (auto& latency : latencies)
+        {
+            auto const sent = receive();
+            latency         = now_ns() - sent;
+        }
+    }};
+
+    auto next = clock_type::now();
+    for (std::size_t i = 0; i < messages; ++i)
+    {
+        while (clock_type::now() < next)
+        {
+            _mm_pause();
+        }
+        next += interval;
+        send(now_ns());
+    }
+    consumer.join();
+
+    std::sort(latencies.begin(), latencies.end());
+    auto const at = [&](double q) {
+        return latencies[std::min(latencies.size() - 1, static_cast<std::size_t>(q * latencies.size()))];
+    };
+    std::printf("%-28s p50 %7lld ns  p99 %8lld ns  p999 %9lld ns  max %9lld ns\n", name,
+                static_cast<long long>(at(0.50)), static_cast<long long>(at(0.99)),
+                static_cast<long long>(at(0.999)), static_cast<long long>(latencies.back()));
+}
+
+constexpr auto block_size = std::size_t {64};
+
+}  // namespace
+
+auto main(int argc, char** argv) -> int
+{
+    auto const messages = argc > 1 ? std::stoull(argv[1]) : std::uint64_t {200'000};
+    auto const interval = std::chrono::nanoseconds {argc > 2 ? std::stoll(argv[2]) : 2'000};
+
+    {
+        auto q = std::make_unique<spsc_queue<std::int64_t, 1024>>();
+        measure(
+            "spsc_queue try_push/pop", messages, interval,
+            [&](std::int64_t t) { poll([&] { return q->try_push(t); }); },
+            [&] {
+                auto t = std::int64_t {};
+                poll([&] { return q->try_pop(t); });
+                return t;
+            });
+    }
+
+    {
+        auto q = std::make_unique<concurrent_bounded_queue<std::int64_t, 1024>>();
+        measure(
+            "concurrent_bounded_queue", messages, interval,
+            [&](std::int64_t t) { poll([&] { return q->try_enqueue(t); }); },
+            [&] {
+                auto t = std::optional<std::int64_t> {};
+                poll([&] { return (t = q->try_dequeue()).has_value(); });
+                return *t;
+            });
+    }
+
+    // A block of samples per message, the first one carries the timestamp.
+    {
+        auto q     = std::make_unique<spsc_queue<std::int64_t, 4096>>();
+        auto block = std::array<std::int64_t, block_size> {};
+        auto out   = std::array<std::int64_t, block_size> {};
+        measure(
+            "spsc_queue push_n/pop_n x64", messages / 8, interval * 8,
+            [&](std::int64_t t) {
+                block[0] = t;
+                auto sent = std::size_t {0};
+                poll([&] { return (sent += q->push_n(std::span {block}.subspan(sent))) == block.size(); });
+            },
+            [&] {
+                auto received = std::size_t {0};
+                poll([&] { return (received += q->pop_n(std::span {out}.subspan(received))) == out.size(); });
+                return out[0];
+            });
+    }
+
+    return EXIT_SUCCESS;
+}
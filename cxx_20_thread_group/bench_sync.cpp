@@ -0,0 +1,109 @@
+#include "counting_semaphore.hpp"
+#include "spin_mutex.hpp"
+#include "ticket_mutex.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <latch>
+#include <mutex>
+#include <semaphore>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+std::atomic<std::uint64_t> sink {0};
+
+// A few dozen cycles of work inside and outside the critical section, so
+// the lock is contended but not the only thing going on.
+auto work(std::uint64_t& x, int n) -> void
+{
+    for (auto i = 0; i < n; ++i)
+    {
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+    }
+}
+
+template<typename Body>
+auto run(char const* name, unsigned threads, std::uint64_t ops, Body body) -> void
+{
+    auto start   = std::latch {threads + 1};
+    auto workers = std::vector<std::jthread> {};
+    for (auto t = 0U; t < threads; ++t)
+    {
+        workers.emplace_back([&, t] {
+            start.arrive_and_wait();
+            body(t, ops / threads);
+        });
+    }
+
+    start.arrive_and_wait();
+    auto const t0 = std::chrono::steady_clock::now();
+    workers.clear();
+    auto const t1 = std::chrono::steady_clock::now();
+
+    auto const ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+    std::printf("%-26s %2u threads %8.1f ns/op\n", name, threads, ns / static_cast<double>(ops));
+}
+
+template<typename Mutex>
+auto bench_mutex(char const* name, unsigned threads, std::uint64_t ops) -> void
+{
+    auto mtx    = Mutex {};
+    auto shared = std::uint64_t {1};
+    run(name, threads, ops, [&](unsigned t, std::uint64_t n) {
+        auto local = std::uint64_t {t};
+        for (std::uint64_t i = 0; i < n; ++i)
+        {
+            {
+                auto lock = std::scoped_lock {mtx};
+                work(shared, 8);
+            }
+            work(local, 32);
+        }
+        sink.fetch_add(local, std::memory_order_relaxed);
+    });
+}
+
+// Half as many permits as threads, so about half of them wait at any time.
+template<typename Semaphore>
+auto bench_semaphore(char const* name, unsigned threads, std::uint64_t ops) -> void
+{
+    auto sem = Semaphore {std::max<std::ptrdiff_t>(1, threads / 2)};
+    run(name, threads, ops, [&](unsigned t, std::uint64_t n) {
+        auto local = std::uint64_t {t};
+        for (std::uint64_t i = 0; i < n; ++i)
+        {
+            sem.acquire();
+            work(local, 8);
+            sem.release();
+            work(local, 32);
+        }
+        sink.fetch_add(local, std::memory_order_relaxed);
+    });
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) -> int
+{
+    auto const hw      = std::max(1U, std::thread::hardware_concurrency());
+    auto const threads = argc > 1 ? static_cast<unsigned>(std::stoul(argv[1])) : hw * 2;
+    auto const ops     = argc > 2 ? std::stoull(argv[2]) : std::uint64_t {1'000'000};
+
+    for (auto n = 1U; n <= threads; n *= 2)
+    {
+        bench_mutex<std::mutex>("std::mutex", n, ops);
+        bench_mutex<spin_mutex>("spin_mutex", n, ops);
+        bench_mutex<ticket_mutex>("ticket_mutex", n, ops);
+        bench_semaphore<std::counting_semaphore<1024>>("std::counting_semaphore", n, ops);
+        bench_semaphore<taetl::counting_semaphore<1024>>("taetl::counting_semaphore", n, ops);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,177 @@
+#pragma once
+
+#include "cacheline.hpp"
+
+#include <array>
+#include <atomic>
+#include <concepts>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+// Bounded multi-producer/multi-consumer ring after Dmitry Vyukov. Every slot
+// carries a sequence number that says whose turn it is: pos when the slot is
+// free for the producer of ticket pos, pos + 1 once that producer is done, and
+// pos + QueueDepth after the consumer released it for the next lap. Producers
+// and consumers only contend on their own counter, never on each other.
+//
+// try_enqueue/try_dequeue claim a ticket with a CAS only if its slot is ready.
+// enqueue/dequeue take the next ticket unconditionally and sleep on the slot
+// sequence with std::atomic::wait until their turn comes.
+template<typename Type, std::uint64_t QueueDepth>
+class concurrent_bounded_queue
+{
+    static_assert(QueueDepth > 0);
+
+public:
+    concurrent_bounded_queue() noexcept
+    {
+        for (std::uint64_t i = 0; i < QueueDepth; ++i)
+        {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    concurrent_bounded_queue(concurrent_bounded_queue const&)                    = delete;
+    auto operator=(concurrent_bounded_queue const&) -> concurrent_bounded_queue& = delete;
+
+    ~concurrent_bounded_queue()
+    {
+        auto const tail = tail_pos.load(std::memory_order_relaxed);
+        for (auto pos = head_pos.load(std::memory_order_relaxed); pos != tail; ++pos)
+        {
+            auto& s = slots[pos % QueueDepth];
+            if (s.sequence.load(std::memory_order_relaxed) == pos + 1)
+            {
+                std::destroy_at(s.get());
+            }
+        }
+    }
+
+    static constexpr auto capacity() noexcept -> std::uint64_t { return QueueDepth; }
+
+    auto enqueue(std::convertible_to<Type> auto&& u) -> void
+    {
+        auto const pos = tail_pos.fetch_add(1, std::memory_order_relaxed);
+        auto& s        = slots[pos % QueueDepth];
+        wait_for(s, pos);
+        put(s, pos, std::forward<decltype(u)>(u));
+    }
+
+    auto dequeue() -> Type
+    {
+        auto const pos = head_pos.fetch_add(1, std::memory_order_relaxed);
+        auto& s        = slots[pos % QueueDepth];
+        wait_for(s, pos + 1);
+        return take(s, pos);
+    }
+
+    auto try_enqueue(std::convertible_to<Type> auto&& u) -> bool
+    {
+        auto pos = tail_pos.load(std::memory_order_relaxed);
+        while (true)
+        {
+            auto& s        = slots[pos % QueueDepth];
+            auto const seq = s.sequence.load(std::memory_order_acquire);
+            auto const dif = static_cast<std::int64_t>(seq - pos);
+
+            if (dif == 0)
+            {
+                if (tail_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    put(s, pos, std::forward<decltype(u)>(u));
+                    return true;
+                }
+            }
+            else if (dif < 0)
+            {
+                return false;  // full, the slot still holds last lap's item
+            }
+            else
+            {
+                pos = tail_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    auto try_dequeue() -> std::optional<Type>
+    {
+        auto pos = head_pos.load(std::memory_order_relaxed);
+        while (true)
+        {
+            auto& s        = slots[pos % QueueDepth];
+            auto const seq = s.sequence.load(std::memory_order_acquire);
+            auto const dif = static_cast<std::int64_t>(seq - (pos + 1));
+
+            if (dif == 0)
+            {
+                if (head_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    return take(s, pos);
+                }
+            }
+            else if (dif < 0)
+            {
+                return std::nullopt;  // empty, nobody has filled this slot yet
+            }
+            else
+            {
+                pos = head_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    struct CACHELINE_ALIGNED slot
+    {
+        auto get() noexcept -> Type* { return std::launder(reinterpret_cast<Type*>(storage)); }
+
+        std::atomic<std::uint64_t> sequence;
+        alignas(Type) std::byte storage[sizeof(Type)];
+    };
+
+    static auto wait_for(slot& s, std::uint64_t expected) noexcept -> void
+    {
+        // The other side is usually just a few items behind. Yielding a
+        // while lets it catch up in batches instead of a futex wake per item.
+        for (auto spins = 0; spins < 64; ++spins)
+        {
+            if (s.sequence.load(std::memory_order_acquire) == expected)
+            {
+                return;
+            }
+            std::this_thread::yield();
+        }
+
+        for (auto seq = s.sequence.load(std::memory_order_acquire); seq != expected;
+             seq      = s.sequence.load(std::memory_order_acquire))
+        {
+            s.sequence.wait(seq, std::memory_order_acquire);
+        }
+    }
+
+    static auto put(slot& s, std::uint64_t pos, auto&& u) -> void
+    {
+        ::new (static_cast<void*>(s.storage)) Type(std::forward<decltype(u)>(u));
+        s.sequence.store(pos + 1, std::memory_order_release);
+        s.sequence.notify_all();
+    }
+
+    static auto take(slot& s, std::uint64_t pos) -> Type
+    {
+        auto* item = s.get();
+        Type tmp   = std::move(*item);
+        std::destroy_at(item);
+        s.sequence.store(pos + QueueDepth, std::memory_order_release);
+        s.sequence.notify_all();
+        return tmp;
+    }
+
+    CACHELINE_ALIGNED std::atomic<std::uint64_t> tail_pos {0};
+    CACHELINE_ALIGNED std::atomic<std::uint64_t> head_pos {0};
+    std::array<slot, QueueDepth> slots;
+};
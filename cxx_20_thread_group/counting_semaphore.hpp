@@ -0,0 +1,115 @@
+#pragma once
+
+#include "futex.hpp"
+#include "spin_mutex.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+
+namespace taetl
+{
+// std::counting_semaphore interface. The count is the futex word itself:
+// acquire takes a unit with a CAS, spins adaptively while the count is zero
+// and then sleeps on it. release only enters the kernel if someone sleeps.
+template<ptrdiff_t least_max_value>
+class counting_semaphore
+{
+    static_assert(least_max_value >= 0);
+    static_assert(least_max_value <= std::numeric_limits<std::int32_t>::max(), "the count is a 32 bit futex word");
+
+public:
+    static constexpr ptrdiff_t max() noexcept { return least_max_value; }
+
+    constexpr explicit counting_semaphore(ptrdiff_t desired) : counter(static_cast<std::int32_t>(desired))
+    {
+        assert(desired >= 0);
+        assert(desired <= max());
+    }
+
+    ~counting_semaphore() = default;
+
+    counting_semaphore(const counting_semaphore&) = delete;
+    counting_semaphore& operator=(const counting_semaphore&) = delete;
+
+    void release(ptrdiff_t update = 1)
+    {
+        assert(update >= 0);
+        [[maybe_unused]] auto const old = counter.fetch_add(static_cast<std::int32_t>(update));
+        assert(update <= max() - old);
+
+        if (waiters.load() != 0)
+        {
+            futex_wake(counter, static_cast<std::int32_t>(update));
+        }
+    }
+
+    void acquire() { acquire_slow(std::nullopt); }
+
+    // Returns: true if counter was decremented, otherwise false
+    bool try_acquire() noexcept
+    {
+        auto current = counter.load(std::memory_order_relaxed);
+        while (current > 0)
+        {
+            if (counter.compare_exchange_weak(current, current - 1, std::memory_order_acquire,
+                                              std::memory_order_relaxed))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template<class Rep, class Period>
+    bool try_acquire_for(const std::chrono::duration<Rep, Period>& rel_time)
+    {
+        return acquire_slow(std::chrono::steady_clock::now()
+                            + std::chrono::ceil<std::chrono::steady_clock::duration>(rel_time));
+    }
+
+    template<class Clock, class Duration>
+    bool try_acquire_until(const std::chrono::time_point<Clock, Duration>& abs_time)
+    {
+        return acquire_slow(to_steady(abs_time));
+    }
+
+private:
+    bool acquire_slow(std::optional<std::chrono::steady_clock::time_point> deadline)
+    {
+        if (try_acquire() || spin([this] { return try_acquire(); }))
+        {
+            return true;
+        }
+
+        while (true)
+        {
+            if (try_acquire())
+            {
+                return true;
+            }
+
+            // seq_cst pairs with release: either it sees us waiting, or the
+            // kernel sees its increment and does not put us to sleep.
+            waiters.fetch_add(1);
+            auto const woken = futex_wait(counter, 0, deadline);
+            waiters.fetch_sub(1, std::memory_order_relaxed);
+
+            if (!woken)
+            {
+                return try_acquire();
+            }
+        }
+    }
+
+    std::atomic<std::int32_t> counter;
+    std::atomic<std::int32_t> waiters {0};
+    adaptive_spin spin;
+};
+
+using binary_semaphore = counting_semaphore<1>;
+}  // namespace taetl
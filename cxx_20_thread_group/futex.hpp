@@ -0,0 +1,57 @@
+#pragma once
+
+#include <linux/futex.h>  // for FUTEX_*
+#include <sys/syscall.h>  // for SYS_futex
+#include <time.h>         // for timespec
+#include <unistd.h>       // for syscall
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+
+static_assert(sizeof(std::atomic<std::int32_t>) == sizeof(std::int32_t));
+static_assert(std::atomic<std::int32_t>::is_always_lock_free);
+
+// Sleeps while word still holds expected. The deadline is absolute on
+// CLOCK_MONOTONIC, which is what std::chrono::steady_clock reads. Returns
+// false only on timeout; wakeups, signals and a changed word return true.
+inline auto futex_wait(std::atomic<std::int32_t>& word, std::int32_t expected,
+                       std::optional<std::chrono::steady_clock::time_point> deadline) noexcept -> bool
+{
+    auto ts       = timespec {};
+    auto* timeout = static_cast<timespec*>(nullptr);
+    if (deadline)
+    {
+        auto const ns = std::max<std::int64_t>(0, deadline->time_since_epoch() / std::chrono::nanoseconds {1});
+        ts.tv_sec     = static_cast<time_t>(ns / 1'000'000'000);
+        ts.tv_nsec    = static_cast<long>(ns % 1'000'000'000);
+        timeout       = &ts;
+    }
+
+    auto const rc = syscall(SYS_futex, reinterpret_cast<std::int32_t*>(&word), FUTEX_WAIT_BITSET_PRIVATE, expected,
+                            timeout, nullptr, FUTEX_BITSET_MATCH_ANY);
+    return !(rc == -1 && errno == ETIMEDOUT);
+}
+
+inline auto futex_wake(std::atomic<std::int32_t>& word, std::int32_t count) noexcept -> void
+{
+    syscall(SYS_futex, reinterpret_cast<std::int32_t*>(&word), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+}
+
+template<typename Clock, typename Duration>
+auto to_steady(std::chrono::time_point<Clock, Duration> const& abs_time) -> std::chrono::steady_clock::time_point
+{
+    using std::chrono::steady_clock;
+    if constexpr (std::is_same_v<Clock, steady_clock>)
+    {
+        return std::chrono::time_point_cast<steady_clock::duration>(abs_time);
+    }
+    else
+    {
+        return steady_clock::now() + std::chrono::ceil<steady_clock::duration>(abs_time - Clock::now());
+    }
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <boost/atomic/atomic_flag.hpp>
+
+#include <emmintrin.h>  // for _mm_pause
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <thread>
+
+// approx. 5x5 ns (= 25 ns), 10x40 ns (= 400 ns), and 3000x350 ns
+// (~ 1 ms), respectively, when measured on a 2.9 GHz Intel i9
+inline constexpr auto spin_iterations = std::array {5, 10, 3000};
+
+// Polls try_once with the spin_mutex backoff schedule, cutting the last stage
+// short after long_rounds. Returns true as soon as try_once does.
+template<typename TryOnce>
+auto spin_backoff(TryOnce&& try_once, int long_rounds = spin_iterations[2]) noexcept -> bool
+{
+    for (int i = 0; i < spin_iterations[0]; ++i)
+    {
+        if (try_once()) return true;
+    }
+
+    for (int i = 0; i < spin_iterations[1]; ++i)
+    {
+        if (try_once()) return true;
+
+        _mm_pause();
+    }
+
+    for (int i = 0; i < long_rounds; ++i)
+    {
+        if (try_once()) return true;
+
+        _mm_pause();
+        _mm_pause();
+        _mm_pause();
+        _mm_pause();
+        _mm_pause();
+        _mm_pause();
+        _mm_pause();
+        _mm_pause();
+        _mm_pause();
+        _mm_pause();
+    }
+
+    return false;
+}
+
+// Spin budget in front of a blocking slow path. Keeps a running average of
+// how many polls recent waits needed and allows about twice that, like the
+// adaptive mutexes in glibc. Waits that never end while spinning shrink the
+// budget back down over time, since they record the full budget.
+class adaptive_spin
+{
+public:
+    template<typename TryOnce>
+    auto operator()(TryOnce&& try_once) noexcept -> bool
+    {
+        auto const average = estimate.load(std::memory_order_relaxed);
+        auto const budget  = std::min(max_rounds, average * 2 + 10);
+
+        auto polls    = 0;
+        auto const ok = spin_backoff(
+            [&] {
+                ++polls;
+                return try_once();
+            },
+            budget);
+
+        estimate.store(average + (std::min(polls, max_rounds) - average) / 8, std::memory_order_relaxed);
+        return ok;
+    }
+
+private:
+    // About 35 us of the last stage, well below the cost of a futex round trip
+    // once the waiter was descheduled.
+    static constexpr int max_rounds = 100;
+
+    std::atomic<int> estimate {0};
+};
+
+struct spin_mutex
+{
+    void lock() noexcept
+    {
+        while (!spin_backoff([this] { return try_lock(); }))
+        {
+            // waiting longer than we should, let's give other threads
+            // a chance to recover
+            std::this_thread::yield();
+        }
+    }
+
+    bool try_lock() noexcept { return !flag.test_and_set(boost::memory_order_acquire); }
+
+    void unlock() noexcept { flag.clear(boost::memory_order_release); }
+
+private:
+    boost::atomic_flag flag = BOOST_ATOMIC_FLAG_INIT;
+};
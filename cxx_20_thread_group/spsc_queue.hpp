@@ -0,0 +1,172 @@
+#pragma once
+
+#include "cacheline.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+// Wait-free single-producer/single-consumer ring for real-time threads: no
+// locks, no allocation after construction, every call finishes in a bounded
+// number of steps. Positions only grow and are masked into the power-of-two
+// ring. Each side keeps a private copy of the other side's position and only
+// reloads the shared one when the copy shows too little room or data, so in
+// steady state the producer and consumer rarely touch each other's lines.
+//
+// Slots are assigned, not constructed, so Type needs to be default
+// constructible and move assignable. Popped slots keep their moved-from value.
+template<typename Type, std::size_t Capacity>
+class spsc_queue
+{
+    static_assert(std::has_single_bit(Capacity), "Capacity must be a power of two");
+    static_assert(std::is_default_constructible_v<Type> && std::is_nothrow_move_assignable_v<Type>);
+
+public:
+    spsc_queue() = default;
+
+    spsc_queue(spsc_queue const&)                    = delete;
+    auto operator=(spsc_queue const&) -> spsc_queue& = delete;
+
+    static constexpr auto capacity() noexcept -> std::size_t { return Capacity; }
+
+    // Producer only.
+    auto try_push(std::convertible_to<Type> auto&& u) noexcept(std::is_nothrow_assignable_v<Type&, decltype(u)>)
+        -> bool
+    {
+        auto const tail = producer.tail.load(std::memory_order_relaxed);
+        if (writable(tail) == 0)
+        {
+            return false;
+        }
+
+        slots[tail & mask] = std::forward<decltype(u)>(u);
+        producer.tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Producer only. Copies as many leading items as fit, in at most two
+    // contiguous runs, and publishes them with a single store.
+    auto push_n(std::span<Type const> items) noexcept(std::is_nothrow_copy_assignable_v<Type>) -> std::size_t
+    {
+        auto const tail  = producer.tail.load(std::memory_order_relaxed);
+        auto const count = std::min(items.size(), writable(tail, items.size()));
+        if (count == 0)
+        {
+            return 0;
+        }
+
+        auto const first = tail & mask;
+        auto const run   = std::min(count, Capacity - first);
+        std::copy_n(items.begin(), run, slots.begin() + static_cast<std::ptrdiff_t>(first));
+        std::copy_n(items.begin() + static_cast<std::ptrdiff_t>(run), count - run, slots.begin());
+
+        producer.tail.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    // Consumer only.
+    auto try_pop(Type& out) noexcept -> bool
+    {
+        auto const head = consumer.head.load(std::memory_order_relaxed);
+        if (readable(head) == 0)
+        {
+            return false;
+        }
+
+        out = std::move(slots[head & mask]);
+        consumer.head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only.
+    auto try_pop() noexcept(std::is_nothrow_move_constructible_v<Type>) -> std::optional<Type>
+    {
+        auto const head = consumer.head.load(std::memory_order_relaxed);
+        if (readable(head) == 0)
+        {
+            return std::nullopt;
+        }
+
+        auto result = std::optional<Type> {std::move(slots[head & mask])};
+        consumer.head.store(head + 1, std::memory_order_release);
+        return result;
+    }
+
+    // Consumer only. Moves up to out.size() items into out, in at most two
+    // contiguous runs, and releases their slots with a single store.
+    auto pop_n(std::span<Type> out) noexcept -> std::size_t
+    {
+        auto const head  = consumer.head.load(std::memory_order_relaxed);
+        auto const count = std::min(out.size(), readable(head, out.size()));
+        if (count == 0)
+        {
+            return 0;
+        }
+
+        auto const first = head & mask;
+        auto const run   = std::min(count, Capacity - first);
+        auto const begin = slots.begin() + static_cast<std::ptrdiff_t>(first);
+        std::move(begin, begin + static_cast<std::ptrdiff_t>(run), out.begin());
+        std::move(slots.begin(), slots.begin() + static_cast<std::ptrdiff_t>(count - run),
+                  out.begin() + static_cast<std::ptrdiff_t>(run));
+
+        consumer.head.store(head + count, std::memory_order_release);
+        return count;
+    }
+
+    // Exact when called from either end while the other one is idle.
+    [[nodiscard]] auto size_approx() const noexcept -> std::size_t
+    {
+        return producer.tail.load(std::memory_order_acquire) - consumer.head.load(std::memory_order_acquire);
+    }
+
+    [[nodiscard]] auto empty() const noexcept -> bool { return size_approx() == 0; }
+
+private:
+    static constexpr std::size_t mask = Capacity - 1;
+
+    // Free slots, reloading the consumer position only if the cached one
+    // leaves fewer than wanted.
+    auto writable(std::size_t tail, std::size_t wanted = 1) noexcept -> std::size_t
+    {
+        if (Capacity - (tail - producer.head_cache) < wanted)
+        {
+            producer.head_cache = consumer.head.load(std::memory_order_acquire);
+        }
+        return Capacity - (tail - producer.head_cache);
+    }
+
+    auto readable(std::size_t head, std::size_t wanted = 1) noexcept -> std::size_t
+    {
+        if (consumer.tail_cache - head < wanted)
+        {
+            consumer.tail_cache = producer.tail.load(std::memory_order_acquire);
+        }
+        return consumer.tail_cache - head;
+    }
+
+    // Written by the producer, read by the consumer on a cache miss.
+    struct CACHELINE_ALIGNED producer_side
+    {
+        std::atomic<std::size_t> tail {0};
+        std::size_t head_cache {0};
+    };
+
+    // Written by the consumer, read by the producer on a cache miss.
+    struct CACHELINE_ALIGNED consumer_side
+    {
+        std::atomic<std::size_t> head {0};
+        std::size_t tail_cache {0};
+    };
+
+    producer_side producer;
+    consumer_side consumer;
+    CACHELINE_ALIGNED std::array<Type, Capacity> slots {};
+};
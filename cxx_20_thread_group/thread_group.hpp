@@ -0,0 +1,208 @@
+#pragma once
+
+#include "cacheline.hpp"
+#include "futex.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <stop_token>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Items processed by one worker. Only its own thread writes it, so
+// incrementing is a plain load and store, readers see a recent value.
+class worker_counter
+{
+public:
+    auto operator++() noexcept -> worker_counter&
+    {
+        add(1);
+        return *this;
+    }
+
+    auto add(std::uint64_t n) noexcept -> void
+    {
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] auto load() const noexcept -> std::uint64_t { return value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<std::uint64_t> value {0};
+};
+
+struct worker_report
+{
+    std::size_t id {0};
+    std::uint64_t count {0};
+    double seconds {0.0};
+    bool finished {false};
+    std::exception_ptr error;
+
+    [[nodiscard]] auto rate() const noexcept -> double { return seconds > 0.0 ? count / seconds : 0.0; }
+};
+
+// Owns a set of workers that share one stop_source. Every worker runs its
+// own callable, which may take (std::stop_token, worker_counter&),
+// (std::stop_token) or nothing. An exception ends only the worker that threw
+// it and is kept for report(). Destruction requests stop and joins, so no
+// worker outlives the group.
+//
+// spawn, join and report are meant to be called from the owning thread,
+// request_stop and the stop source from anywhere.
+class thread_group
+{
+public:
+    thread_group() = default;
+
+    thread_group(std::uint64_t n, std::invocable<std::stop_token> auto&& f)
+    {
+        for (auto i = 0u; i < n; i++) spawn(f);
+    }
+
+    thread_group(thread_group const&)                    = delete;
+    auto operator=(thread_group const&) -> thread_group& = delete;
+
+    ~thread_group()
+    {
+        request_stop();
+        join();
+    }
+
+    template<typename Func>
+    auto spawn(Func&& func) -> std::size_t
+    {
+        auto const id = members.size();
+        auto& w       = *members.emplace_back(std::make_unique<worker>());
+        w.started     = std::chrono::steady_clock::now();
+        running.fetch_add(1, std::memory_order_relaxed);
+
+        auto body = [this, &w, f = std::forward<Func>(func), token = stop.get_token()]() mutable {
+            try
+            {
+                if constexpr (std::invocable<Func&, std::stop_token, worker_counter&>)
+                {
+                    f(token, w.counter);
+                }
+                else if constexpr (std::invocable<Func&, std::stop_token>)
+                {
+                    f(token);
+                }
+                else
+                {
+                    f();
+                }
+            }
+            catch (...)
+            {
+                w.error = std::current_exception();
+            }
+
+            w.finished = std::chrono::steady_clock::now();
+            w.done.store(true, std::memory_order_release);
+            running.fetch_sub(1);
+            futex_wake(running, std::numeric_limits<std::int32_t>::max());
+        };
+
+        try
+        {
+            w.thread = std::thread {std::move(body)};
+        }
+        catch (...)
+        {
+            running.fetch_sub(1, std::memory_order_relaxed);
+            members.pop_back();
+            throw;
+        }
+
+        return id;
+    }
+
+    auto request_stop() noexcept -> bool { return stop.request_stop(); }
+
+    [[nodiscard]] auto get_stop_source() const noexcept -> std::stop_source { return stop; }
+
+    [[nodiscard]] auto get_stop_token() const noexcept -> std::stop_token { return stop.get_token(); }
+
+    [[nodiscard]] auto size() const noexcept -> std::size_t { return members.size(); }
+
+    auto join() -> void
+    {
+        for (auto& w : members)
+        {
+            if (w->thread.joinable()) w->thread.join();
+        }
+    }
+
+    // Returns false if some worker is still running at the deadline. Those
+    // stay untouched; call again, or request_stop first.
+    template<class Rep, class Period>
+    auto join_for(std::chrono::duration<Rep, Period> const& rel_time) -> bool
+    {
+        return join_until(std::chrono::steady_clock::now()
+                          + std::chrono::ceil<std::chrono::steady_clock::duration>(rel_time));
+    }
+
+    template<class Clock, class Duration>
+    auto join_until(std::chrono::time_point<Clock, Duration> const& abs_time) -> bool
+    {
+        auto const deadline = to_steady(abs_time);
+        for (auto n = running.load(); n != 0; n = running.load())
+        {
+            if (!futex_wait(running, n, deadline) && running.load() != 0)
+            {
+                return false;
+            }
+        }
+
+        join();
+        return true;
+    }
+
+    // Per worker: items counted so far, time since it started (or until it
+    // finished) and its exception, if it threw.
+    [[nodiscard]] auto report() const -> std::vector<worker_report>
+    {
+        auto const now = std::chrono::steady_clock::now();
+        auto result    = std::vector<worker_report> {};
+        result.reserve(members.size());
+
+        for (std::size_t id = 0; id < members.size(); ++id)
+        {
+            auto const& w    = *members[id];
+            auto const done  = w.done.load(std::memory_order_acquire);
+            auto const until = done ? w.finished : now;
+            result.push_back(worker_report {
+                id,
+                w.counter.load(),
+                std::chrono::duration<double>(until - w.started).count(),
+                done,
+                done ? w.error : nullptr,
+            });
+        }
+        return result;
+    }
+
+private:
+    struct worker
+    {
+        CACHELINE_ALIGNED worker_counter counter;
+        std::thread thread;
+        std::chrono::steady_clock::time_point started;
+        std::chrono::steady_clock::time_point finished;
+        std::exception_ptr error;
+        std::atomic<bool> done {false};
+    };
+
+    std::vector<std::unique_ptr<worker>> members;
+    std::stop_source stop;
+    std::atomic<std::int32_t> running {0};
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "cacheline.hpp"
+#include "futex.hpp"
+#include "spin_mutex.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <optional>
+
+// FIFO lock. Only the thread next in line spins, everyone further back goes
+// straight to sleep on out, so a long queue does not burn the CPUs the
+// holder needs. unlock wakes all sleepers, each one re-checks its ticket.
+struct ticket_mutex
+{
+public:
+    auto lock() noexcept -> void
+    {
+        auto const my = in.fetch_add(1, std::memory_order_relaxed);
+        while (true)
+        {
+            auto const now = out.load(std::memory_order_acquire);
+            if (now == my)
+            {
+                return;
+            }
+
+            auto const ahead = static_cast<std::uint32_t>(my) - static_cast<std::uint32_t>(now);
+            if (ahead == 1 && spin([this, my] { return out.load(std::memory_order_acquire) == my; }))
+            {
+                return;
+            }
+
+            sleepers.fetch_add(1);
+            futex_wait(out, now, std::nullopt);
+            sleepers.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    auto try_lock() noexcept -> bool
+    {
+        auto now = out.load(std::memory_order_acquire);
+        auto const next = static_cast<std::int32_t>(static_cast<std::uint32_t>(now) + 1U);
+        return in.compare_exchange_strong(now, next, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    auto unlock() noexcept -> void
+    {
+        out.fetch_add(1);
+        if (sleepers.load() != 0)
+        {
+            futex_wake(out, std::numeric_limits<std::int32_t>::max());
+        }
+    }
+
+private:
+    alignas(CACHELINE_SIZE) std::atomic<std::int32_t> in {0};
+    alignas(CACHELINE_SIZE) std::atomic<std::int32_t> out {0};
+    std::atomic<std::int32_t> sleepers {0};
+    adaptive_spin spin;
+};
@@ -0,0 +1,399 @@
+#pragma once
+
+#include "scheduler.hpp"
+#include "sender.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <stop_token>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace mc
+{
+
+namespace detail
+{
+
+// Running chunks look at the stop token once per this many elements.
+inline constexpr std::size_t StopCheckInterval = 1024;
+
+// Parallel algorithms split their index space into this many pieces.
+template<typename Sched>
+auto Concurrency(Sched const& sched) noexcept -> std::size_t
+{
+    if constexpr (requires { sched.Concurrency(); })
+    {
+        return std::max<std::size_t>(1, sched.Concurrency());
+    }
+    else
+    {
+        return 1;
+    }
+}
+
+// Waits for the upstream value, cuts [0, Size) into at most Concurrency()
+// contiguous chunks and schedules all but the first one, which runs on the
+// thread that delivered the value. The last chunk to finish completes the
+// receiver, with the first exception any chunk threw if there was one.
+// Chunks still queued when a stop is requested are dropped by the scheduler,
+// running ones give up at their next stop check, and the whole operation then
+// completes with set_stopped.
+//
+// The Policy supplies the index space, the per-chunk work and the
+// completion, see BulkPolicy and ReducePolicy. The upstream value is passed
+// as an empty pack for void senders.
+template<typename Upstream, typename Sched, typename Policy, typename Receiver>
+class ChunkedOp
+{
+public:
+    using upstream_type = SenderValue<Upstream>;
+
+    ChunkedOp(Upstream&& upstream, Sched const& sched, Policy policy, Receiver r)
+        : receiver_ {std::move(r)}
+        , policy_ {std::move(policy)}
+        , sched_ {sched}
+        , concurrency_ {Concurrency(sched)}
+        , upstreamOp_ {std::move(upstream).connect(UpstreamReceiver {this})}
+    {
+        if (concurrency_ > 1)
+        {
+            chunks_ = std::make_unique<std::optional<Chunk>[]>(concurrency_ - 1);
+        }
+    }
+
+    ChunkedOp(ChunkedOp const&)                    = delete;
+    auto operator=(ChunkedOp const&) -> ChunkedOp& = delete;
+
+    auto start() noexcept -> void { upstreamOp_.start(); }
+
+private:
+    struct UpstreamReceiver
+    {
+        ChunkedOp* op_;
+
+        template<typename... Values>
+        auto set_value(Values&&... vs) noexcept -> void
+        {
+            op_->value_.emplace(std::forward<Values>(vs)...);
+            op_->launch();
+        }
+
+        auto set_exception(std::exception_ptr e) noexcept -> void { op_->receiver_.set_exception(std::move(e)); }
+
+        auto set_stopped() noexcept -> void { op_->receiver_.set_stopped(); }
+
+        [[nodiscard]] auto get_stop_token() const noexcept -> std::stop_token { return GetStopToken(op_->receiver_); }
+    };
+
+    struct ChunkReceiver
+    {
+        ChunkedOp* op_;
+        std::size_t index_;
+
+        auto set_value() noexcept -> void { op_->runChunk(index_); }
+
+        auto set_exception(std::exception_ptr e) noexcept -> void
+        {
+            op_->fail(std::move(e));
+            op_->arrive();
+        }
+
+        auto set_stopped() noexcept -> void
+        {
+            op_->stopped_.store(true, std::memory_order_relaxed);
+            op_->arrive();
+        }
+
+        [[nodiscard]] auto get_stop_token() const noexcept -> std::stop_token { return GetStopToken(op_->receiver_); }
+    };
+
+    using ScheduleOp = decltype(std::declval<Sched const&>().schedule().connect(std::declval<ChunkReceiver>()));
+
+    struct Chunk
+    {
+        Chunk(ChunkedOp* op, std::size_t index) : op_ {op->sched_.schedule().connect(ChunkReceiver {op, index})} {}
+
+        ScheduleOp op_;
+    };
+
+    using UpstreamOp = decltype(std::declval<Upstream>().connect(std::declval<UpstreamReceiver>()));
+
+    template<typename Func>
+    auto withValue(Func&& func) -> decltype(auto)
+    {
+        if constexpr (std::is_void_v<upstream_type>)
+        {
+            return func();
+        }
+        else
+        {
+            return func(*value_);
+        }
+    }
+
+    auto launch() noexcept -> void
+    {
+        try
+        {
+            size_   = withValue([this](auto&... v) -> std::size_t { return policy_.Size(v...); });
+            pieces_ = std::clamp<std::size_t>(size_, 1, concurrency_);
+            policy_.Prepare(pieces_);
+        }
+        catch (...)
+        {
+            receiver_.set_exception(std::current_exception());
+            return;
+        }
+
+        remaining_.store(pieces_, std::memory_order_relaxed);
+        for (std::size_t i = 1; i < pieces_; ++i)
+        {
+            auto& chunk = chunks_[i - 1].emplace(this, i);
+            chunk.op_.start();
+        }
+        runChunk(0);
+    }
+
+    auto runChunk(std::size_t index) noexcept -> void
+    {
+        auto const begin = size_ * index / pieces_;
+        auto const end   = size_ * (index + 1) / pieces_;
+        auto const token = GetStopToken(receiver_);
+        try
+        {
+            withValue([&](auto&... v) { policy_.Run(index, begin, end, token, v...); });
+        }
+        catch (...)
+        {
+            fail(std::current_exception());
+        }
+        if (token.stop_requested())
+        {
+            stopped_.store(true, std::memory_order_relaxed);
+        }
+        arrive();
+    }
+
+    auto fail(std::exception_ptr e) noexcept -> void
+    {
+        if (!failed_.exchange(true, std::memory_order_relaxed))
+        {
+            error_ = std::move(e);
+        }
+    }
+
+    auto arrive() noexcept -> void
+    {
+        if (remaining_.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        {
+            return;
+        }
+
+        if (failed_.load(std::memory_order_relaxed))
+        {
+            receiver_.set_exception(std::move(error_));
+            return;
+        }
+
+        if (stopped_.load(std::memory_order_relaxed))
+        {
+            receiver_.set_stopped();
+            return;
+        }
+
+        if constexpr (std::is_void_v<upstream_type>)
+        {
+            policy_.Complete(receiver_);
+        }
+        else
+        {
+            policy_.Complete(receiver_, std::move(*value_));
+        }
+    }
+
+    Receiver receiver_;
+    Policy policy_;
+    Sched sched_;
+    std::size_t concurrency_;
+    std::size_t size_ {0};
+    std::size_t pieces_ {1};
+    std::optional<Stored<upstream_type>> value_;
+    std::unique_ptr<std::optional<Chunk>[]> chunks_;
+    std::atomic<std::size_t> remaining_ {0};
+    std::atomic<bool> failed_ {false};
+    std::atomic<bool> stopped_ {false};
+    std::exception_ptr error_;
+    UpstreamOp upstreamOp_;
+};
+
+template<typename Upstream, typename Sched, typename Policy>
+struct ChunkedSender
+{
+    using value_type = typename Policy::template result_type<SenderValue<Upstream>>;
+
+    Upstream upstream_;
+    Sched sched_;
+    Policy policy_;
+
+    template<typename Receiver>
+    auto connect(Receiver r) && -> ChunkedOp<Upstream, Sched, Policy, Receiver>
+    {
+        return {std::move(upstream_), sched_, std::move(policy_), std::move(r)};
+    }
+
+    template<typename Receiver>
+    auto connect(Receiver r) const& -> ChunkedOp<Upstream, Sched, Policy, Receiver>
+    {
+        return {Upstream {upstream_}, sched_, policy_, std::move(r)};
+    }
+};
+
+template<typename Func>
+struct BulkPolicy
+{
+    template<typename T>
+    using result_type = T;
+
+    std::size_t count;
+    Func func;
+
+    auto Size(auto&... /*value*/) const noexcept -> std::size_t { return count; }
+
+    auto Prepare(std::size_t /*pieces*/) noexcept -> void {}
+
+    auto Run(std::size_t /*chunk*/, std::size_t begin, std::size_t end, std::stop_token const& token, auto&... value)
+        -> void
+    {
+        for (auto i = begin; i != end; ++i)
+        {
+            if (i % StopCheckInterval == 0 && token.stop_requested())
+            {
+                return;
+            }
+            std::invoke(func, i, value...);
+        }
+    }
+
+    template<typename Receiver, typename... Values>
+    auto Complete(Receiver& r, Values&&... value) noexcept -> void
+    {
+        r.set_value(std::forward<Values>(value)...);
+    }
+};
+
+template<typename T, typename Op>
+struct ReducePolicy
+{
+    template<typename>
+    using result_type = T;
+
+    T init;
+    Op op;
+    std::vector<std::optional<T>> partials {};
+
+    template<std::ranges::random_access_range Range>
+        requires std::ranges::sized_range<Range>
+    auto Size(Range& range) const -> std::size_t
+    {
+        return static_cast<std::size_t>(std::ranges::size(range));
+    }
+
+    auto Prepare(std::size_t pieces) -> void { partials.assign(pieces, std::nullopt); }
+
+    template<typename Range>
+    auto Run(std::size_t chunk, std::size_t begin, std::size_t end, std::stop_token const& token, Range& range) -> void
+    {
+        // Only the first chunk folds into init, so init counts once however
+        // the range is split. Later chunks are never empty and start from
+        // their first element.
+        auto const first = std::ranges::begin(range);
+        auto acc         = chunk == 0 ? T {init} : static_cast<T>(first[static_cast<std::ptrdiff_t>(begin)]);
+        for (auto i = chunk == 0 ? begin : begin + 1; i != end; ++i)
+        {
+            if (i % StopCheckInterval == 0 && token.stop_requested())
+            {
+                return;
+            }
+            acc = std::invoke(op, std::move(acc), first[static_cast<std::ptrdiff_t>(i)]);
+        }
+        partials[chunk].emplace(std::move(acc));
+    }
+
+    // Partials are folded in chunk order, so the result does not depend on
+    // which worker finished first.
+    template<typename Receiver, typename Range>
+    auto Complete(Receiver& r, Range&& /*range*/) noexcept -> void
+    {
+        try
+        {
+            auto acc = std::move(*partials.front());
+            for (auto it = std::next(partials.begin()); it != partials.end(); ++it)
+            {
+                acc = std::invoke(op, std::move(acc), std::move(**it));
+            }
+            r.set_value(std::move(acc));
+        }
+        catch (...)
+        {
+            r.set_exception(std::current_exception());
+        }
+    }
+};
+}  // namespace detail
+
+/**
+ * @brief Calls func(i, value) for every i in [0, n), spread over the
+ * scheduler's workers, then completes once with the upstream value.
+ *
+ * func gets the value as an lvalue and is called concurrently from different
+ * chunks, so it may only touch the parts of value that belong to its i. For
+ * void senders func is called as func(i).
+ */
+template<Sender LazyFuture, Scheduler Sched, typename Func>
+auto Bulk(LazyFuture&& future, Sched sched, std::size_t n, Func&& func)
+{
+    using Policy = detail::BulkPolicy<std::decay_t<Func>>;
+    return detail::ChunkedSender<std::decay_t<LazyFuture>, Sched, Policy> {
+        std::forward<LazyFuture>(future), std::move(sched), Policy {n, std::forward<Func>(func)}};
+}
+
+template<Sender LazyFuture, typename Func>
+auto Bulk(LazyFuture&& future, std::size_t n, Func&& func)
+{
+    return mc::Bulk(std::forward<LazyFuture>(future), StaticThreadPool::GlobalInstance().GetScheduler(), n,
+                    std::forward<Func>(func));
+}
+
+/**
+ * @brief Folds the upstream value, a sized random-access range, with op
+ * and completes with the result.
+ *
+ * Like std::reduce, init is folded in exactly once: the first chunk starts
+ * from it, every other chunk from its first element converted to T, and
+ * the partial results are combined with op in chunk order. So op has to be
+ * associative and accept (T, element) as well as (T, T).
+ */
+template<Sender LazyFuture, Scheduler Sched, typename T, typename Op>
+auto Reduce(LazyFuture&& future, Sched sched, T init, Op&& op)
+{
+    using Policy = detail::ReducePolicy<T, std::decay_t<Op>>;
+    return detail::ChunkedSender<std::decay_t<LazyFuture>, Sched, Policy> {
+        std::forward<LazyFuture>(future), std::move(sched), Policy {std::move(init), std::forward<Op>(op)}};
+}
+
+template<Sender LazyFuture, typename T, typename Op>
+auto Reduce(LazyFuture&& future, T init, Op&& op)
+{
+    return mc::Reduce(std::forward<LazyFuture>(future), StaticThreadPool::GlobalInstance().GetScheduler(),
+                      std::move(init), std::forward<Op>(op));
+}
+}  // namespace mc
@@ -0,0 +1,197 @@
+#include "algorithm.hpp"
+#include "scheduler.hpp"
+#include "sender.hpp"
+
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+// Stands in for reading a file: one decimal number per line.
+auto Load(std::size_t lines) -> std::string
+{
+    auto text = std::string {};
+    text.reserve(lines * 8);
+    auto x = std::uint64_t {42};
+    for (std::size_t i = 0; i < lines; ++i)
+    {
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+        text += std::to_string(x >> 44);
+        text += '\n';
+    }
+    return text;
+}
+
+// Cuts the text into roughly equal pieces that end on a line break.
+auto Split(std::string_view text, std::size_t pieces) -> std::vector<std::string_view>
+{
+    auto result = std::vector<std::string_view> {};
+    auto begin  = std::size_t {0};
+    for (std::size_t i = 1; i <= pieces && begin < text.size(); ++i)
+    {
+        auto end = i == pieces ? text.size() : text.find('\n', std::max(begin, text.size() * i / pieces));
+        end      = end == std::string_view::npos ? text.size() : end + 1;
+        result.push_back(text.substr(begin, end - begin));
+        begin = end;
+    }
+    result.resize(pieces);
+    return result;
+}
+
+auto ParseSum(std::string_view piece) -> std::uint64_t
+{
+    auto sum          = std::uint64_t {0};
+    auto const* first = piece.data();
+    auto const* last  = piece.data() + piece.size();
+    while (first < last)
+    {
+        auto value        = std::uint64_t {0};
+        auto const [p, _] = std::from_chars(first, last, value);
+        sum += value;
+        first = p + 1;
+    }
+    return sum;
+}
+
+struct Job
+{
+    std::string text;
+    std::vector<std::string_view> pieces;
+    std::vector<std::uint64_t> sums;
+};
+
+// The blocking style: a fixed pool of threads running packaged_tasks, and
+// the caller waits on one std::future per piece.
+class FuturePool
+{
+public:
+    explicit FuturePool(std::size_t threads)
+    {
+        for (std::size_t i = 0; i < threads; ++i)
+        {
+            workers_.emplace_back([this] {
+                while (true)
+                {
+                    auto task = std::packaged_task<std::uint64_t()> {};
+                    {
+                        auto lock = std::unique_lock {mutex_};
+                        cv_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+                        if (tasks_.empty())
+                        {
+                            return;
+                        }
+                        task = std::move(tasks_.front());
+                        tasks_.pop_front();
+                    }
+                    task();
+                }
+            });
+        }
+    }
+
+    ~FuturePool()
+    {
+        {
+            auto lock = std::scoped_lock {mutex_};
+            stop_     = true;
+        }
+        cv_.notify_all();
+    }
+
+    auto Submit(std::function<std::uint64_t()> func) -> std::future<std::uint64_t>
+    {
+        auto task   = std::packaged_task<std::uint64_t()> {std::move(func)};
+        auto result = task.get_future();
+        {
+            auto lock = std::scoped_lock {mutex_};
+            tasks_.push_back(std::move(task));
+        }
+        cv_.notify_one();
+        return result;
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::packaged_task<std::uint64_t()>> tasks_;
+    bool stop_ {false};
+    std::vector<std::jthread> workers_;
+};
+
+template<typename Func>
+auto Measure(char const* name, int runs, Func func) -> void
+{
+    auto best     = std::chrono::nanoseconds::max();
+    auto checksum = std::uint64_t {0};
+    for (auto r = 0; r < runs; ++r)
+    {
+        auto const t0 = std::chrono::steady_clock::now();
+        checksum      = func();
+        auto const t1 = std::chrono::steady_clock::now();
+        best          = std::min(best, std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0));
+    }
+    std::printf("%-28s %10.3f ms  (checksum %llu)\n", name, static_cast<double>(best.count()) / 1e6,
+                static_cast<unsigned long long>(checksum));
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) -> int
+{
+    auto const lines   = argc > 1 ? std::stoull(argv[1]) : std::uint64_t {2'000'000};
+    auto const pieces  = argc > 2 ? std::stoull(argv[2]) : std::uint64_t {256};
+    auto const threads = std::max(1U, std::thread::hardware_concurrency());
+    auto const runs    = 10;
+
+    auto pool    = mc::StaticThreadPool {threads};
+    auto futures = FuturePool {threads};
+    auto sched   = pool.GetScheduler();
+
+    // load -> parse pieces in parallel -> merge, as one lazy graph. Nothing
+    // runs until SyncWait starts it, and no thread blocks in between.
+    auto graph = mc::Reduce(mc::Then(mc::Bulk(mc::Async(sched,
+                                                        [&] {
+                                                            auto job   = Job {Load(lines), {}, {}};
+                                                            job.pieces = Split(job.text, pieces);
+                                                            job.sums.resize(pieces);
+                                                            return job;
+                                                        }),
+                                              sched, pieces,
+                                              [](std::size_t i, Job& job) { job.sums[i] = ParseSum(job.pieces[i]); }),
+                                     [](Job job) { return std::move(job.sums); }),
+                            sched, std::uint64_t {0}, std::plus<> {});
+
+    Measure("mc::Bulk + mc::Reduce", runs, [&] { return mc::SyncWait(graph); });
+
+    Measure("std::future per piece", runs, [&] {
+        auto job     = Job {Load(lines), {}, {}};
+        job.pieces   = Split(job.text, pieces);
+        auto pending = std::vector<std::future<std::uint64_t>> {};
+        pending.reserve(pieces);
+        for (auto piece : job.pieces)
+        {
+            pending.push_back(futures.Submit([piece] { return ParseSum(piece); }));
+        }
+        auto sum = std::uint64_t {0};
+        for (auto& f : pending)
+        {
+            sum += f.get();
+        }
+        return sum;
+    });
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,186 @@
+#include "scheduler.hpp"
+#include "sender.hpp"
+#include "when_any.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+using namespace std::chrono_literals;
+
+// Remembers when and how the operation completed.
+struct Completion
+{
+    std::atomic<bool> done {false};
+    bool stopped {false};
+    Clock::time_point at;
+
+    auto Wait() -> void { done.wait(false, std::memory_order_acquire); }
+};
+
+struct RecordingReceiver
+{
+    Completion* c;
+    std::stop_token token;
+
+    auto finish(bool stopped) noexcept -> void
+    {
+        auto* completion    = c;
+        completion->at      = Clock::now();
+        completion->stopped = stopped;
+        completion->done.store(true, std::memory_order_release);
+        completion->done.notify_one();
+    }
+
+    template<typename... Values>
+    auto set_value(Values&&... /*vs*/) noexcept -> void
+    {
+        finish(false);
+    }
+
+    auto set_exception(std::exception_ptr /*e*/) noexcept -> void { finish(false); }
+
+    auto set_stopped() noexcept -> void { finish(true); }
+
+    [[nodiscard]] auto get_stop_token() const noexcept -> std::stop_token { return token; }
+};
+
+// Busy loop that gives up as soon as it is asked to.
+auto Spin(std::stop_token const& token) -> int
+{
+    while (!token.stop_requested())
+    {
+        std::this_thread::yield();
+    }
+    return 0;
+}
+
+auto Report(char const* name, std::vector<double>& us) -> void
+{
+    std::sort(us.begin(), us.end());
+    auto at = [&](double q) { return us[static_cast<std::size_t>(q * static_cast<double>(us.size() - 1))]; };
+    std::printf("%-34s p50 %8.2f us  p99 %8.2f us  max %8.2f us\n", name, at(0.5), at(0.99), us.back());
+}
+
+auto Micros(Clock::duration d) -> double { return std::chrono::duration<double, std::micro>(d).count(); }
+
+// Work stuck behind a busy worker: stop should unlink and complete it on
+// the requesting thread without waiting for the worker.
+auto Queued(int samples) -> void
+{
+    auto single = mc::StaticThreadPool {1};
+    auto sched  = single.GetScheduler();
+    auto us     = std::vector<double> {};
+    for (auto i = 0; i < samples; ++i)
+    {
+        auto blocker = std::stop_source {};
+        auto busy    = Completion {};
+        auto hog     = mc::Async(sched, Spin).connect(RecordingReceiver {&busy, blocker.get_token()});
+        hog.start();
+
+        auto source = std::stop_source {};
+        auto queued = Completion {};
+        auto op     = mc::Async(sched, [] { return 0; }).connect(RecordingReceiver {&queued, source.get_token()});
+        op.start();
+
+        auto const t0 = Clock::now();
+        source.request_stop();
+        queued.Wait();
+        us.push_back(Micros(queued.at - t0));
+
+        blocker.request_stop();
+        busy.Wait();
+    }
+    Report("queued work, stop -> set_stopped", us);
+}
+
+// Work already running on a worker that polls its token.
+auto Running(mc::StaticThreadPool::Scheduler sched, int samples) -> void
+{
+    auto us = std::vector<double> {};
+    for (auto i = 0; i < samples; ++i)
+    {
+        auto source  = std::stop_source {};
+        auto started = std::atomic<bool> {false};
+        auto running = Completion {};
+        auto op      = mc::Async(sched, [&](std::stop_token const& token) {
+                      started.store(true);
+                      return Spin(token);
+                  }).connect(RecordingReceiver {&running, source.get_token()});
+        op.start();
+        while (!started.load())
+        {
+            std::this_thread::yield();
+        }
+
+        auto const t0 = Clock::now();
+        source.request_stop();
+        running.Wait();
+        us.push_back(Micros(running.at - t0));
+    }
+    Report("running work, stop -> completion", us);
+}
+
+// How far past the deadline WithTimeout completes when the work is slow.
+auto Timeout(mc::StaticThreadPool::Scheduler sched, int samples) -> void
+{
+    auto us = std::vector<double> {};
+    for (auto i = 0; i < samples; ++i)
+    {
+        auto const t0 = Clock::now();
+        try
+        {
+            mc::SyncWait(mc::WithTimeout(mc::Async(sched, Spin), 200us));
+        }
+        catch (mc::TimedOut const&)
+        {
+        }
+        us.push_back(Micros(Clock::now() - t0 - 200us));
+    }
+    Report("WithTimeout(200us) overshoot", us);
+}
+
+// Time from the winner finishing until WhenAny has stopped the loser and
+// completed.
+auto Race(mc::StaticThreadPool::Scheduler sched, int samples) -> void
+{
+    auto us = std::vector<double> {};
+    for (auto i = 0; i < samples; ++i)
+    {
+        auto won = Clock::time_point {};
+        mc::SyncWait(mc::WhenAny(mc::Async(sched, Spin), mc::Then(mc::TimerService::GlobalInstance().After(100us), [&] {
+                                     won = Clock::now();
+                                     return 1;
+                                 })));
+        us.push_back(Micros(Clock::now() - won));
+    }
+    Report("WhenAny winner -> loser released", us);
+}
+
+}  // namespace
+
+auto main(int argc, char** argv) -> int
+{
+    auto const samples = argc > 1 ? std::stoi(argv[1]) : 1000;
+
+    auto pool  = mc::StaticThreadPool {std::max(2U, std::thread::hardware_concurrency())};
+    auto sched = pool.GetScheduler();
+
+    Queued(samples);
+    Running(sched, samples);
+    Timeout(sched, samples);
+    Race(sched, samples);
+
+    return EXIT_SUCCESS;
+}
@@ -1,132 +1,94 @@
-#include <condition_variable>
-#include <future>
+#include "algorithm.hpp"
+#include "scheduler.hpp"
+#include "sender.hpp"
+#include "task.hpp"
+#include "when_any.hpp"
+
+#include <chrono>
+#include <functional>
 #include <iostream>
-#include <thread>
-#include <variant>
+#include <stdexcept>
+#include <stop_token>
+#include <vector>
 
-namespace mc
+namespace
 {
-
-namespace detail
-{
-template<typename PromiseT, typename Cont>
-struct ThenPromise
+auto Twice(mc::StaticThreadPool::Scheduler sched, int i) -> mc::Task<int>
 {
-    PromiseT p_;
-    Cont cont_;
-
-    template<typename... Values>
-    auto set_value(Values... vs) -> void
-    {
-        p_.set_value(cont_(vs...));
-    }
-
-    template<typename Exception>
-    auto set_exception(Exception e) -> void
-    {
-        p_.set_exception(e);
-    }
-};
-
-template<typename T>
-struct SyncWaitState
-{
-    std::mutex Mutex;
-    std::condition_variable CV;
-    std::variant<std::monostate, std::exception_ptr, T> Data;
-};
+    co_return co_await mc::Async(sched, [i] { return i + i; });
+}
 
-template<typename T>
-struct SyncWaitPromise
+auto Sum(mc::StaticThreadPool::Scheduler sched) -> mc::Task<int>
 {
-    SyncWaitState<T>* Pst;
-
-    template<int I, typename... V>
-    auto set(V... xs)
-    {
-        auto lk = std::unique_lock {Pst->Mutex};
-        Pst->Data.template emplace<I>(xs...);
-        Pst->CV.notify_one();
-    }
-
-    template<typename... Values>
-    auto set_value(Values... vs) -> void
+    auto sum = 0;
+    for (auto i = 0; i < 4; ++i)
     {
-        set<2>(vs...);
+        sum += co_await Twice(sched, i);
     }
+    co_return sum;
+}
+}  // namespace
 
-    template<typename Exception>
-    auto set_exception(Exception e) -> void
-    {
-        set<1>(e);
-    }
-};
-}  // namespace detail
-
-struct Sink
+int main()
 {
-
-    template<typename... Values>
-    auto set_value(Values... /*vs*/) -> void
+    auto f  = mc::Async([] { return 42; });
+    auto f2 = mc::Then(f, [](auto i) { return i + i; });
+    std::cout << mc::SyncWait(f2) << '\n';
+
+    // Same chain on other schedulers.
+    std::cout << mc::SyncWait(mc::Then(mc::Async(mc::InlineScheduler {}, [] { return 1; }), [](int i) { return i + 1; }))
+              << '\n';
+
+    auto pool = mc::StaticThreadPool {2};
+    auto loop = mc::RunLoop {};
+
+    // Compute on the pool, finish on this thread's run loop.
+    auto hop = mc::Then(mc::Transfer(mc::Async(pool.GetScheduler(), [] { return std::this_thread::get_id(); }),
+                                     loop.GetScheduler()),
+                        [&](std::thread::id worker) {
+                            std::cout << "pool thread " << (worker != std::this_thread::get_id() ? "!=" : "==")
+                                      << " loop thread\n";
+                            loop.Finish();
+                        });
+    auto op = std::move(hop).connect(mc::Sink {});
+    op.start();
+    loop.Run();
+
+    try
     {
+        mc::SyncWait(mc::Async(pool.GetScheduler(), []() -> int { throw std::runtime_error {"boom"}; }));
     }
-
-    template<typename Exception>
-    auto set_exception(Exception /*e*/) -> void
+    catch (std::exception const& e)
     {
-        std::terminate();
+        std::cout << "caught " << e.what() << '\n';
     }
-};
-
-template<typename LazyFuture, typename Cont>
-auto Then(LazyFuture future, Cont cont)
-{
-    return [=](auto p) { return future(detail::ThenPromise<decltype(p), Cont> {p, cont}); };
-}
 
-template<typename T, typename Task>
-auto SyncWait(Task task)
-{
-    // State
-    detail::SyncWaitState<T> state;
-
-    // Launch the operation
-    task(detail::SyncWaitPromise<T> {&state});
-
-    // Wait
+    // Fill in parallel, then sum in parallel.
+    auto squares = mc::Bulk(mc::Async(pool.GetScheduler(), [] { return std::vector<long>(1000); }),
+                            pool.GetScheduler(), 1000, [](std::size_t i, std::vector<long>& v) {
+                                v[i] = static_cast<long>(i * i);
+                            });
+    std::cout << mc::SyncWait(mc::Reduce(std::move(squares), pool.GetScheduler(), 0L, std::plus<> {})) << '\n';
+
+    // Coroutines await senders and are senders themselves.
+    std::cout << mc::SyncWait(Sum(pool.GetScheduler())) << '\n';
+
+    // Work that is no longer wanted is stopped, not waited for.
+    auto slow = mc::Async(pool.GetScheduler(), [](std::stop_token const& token) {
+        while (!token.stop_requested())
+        {
+            std::this_thread::yield();
+        }
+        return 0;
+    });
+    try
     {
-        auto lk = std::unique_lock {state.Mutex};
-        state.CV.wait(lk, [&state] { return state.Data.index() != 0; });
+        mc::SyncWait(mc::WithTimeout(slow, std::chrono::milliseconds {1}));
     }
-
-    // Throw or Return
-    if (state.Data.index() == 1)
+    catch (mc::TimedOut const& e)
     {
-        std::rethrow_exception(std::get<1>(state.Data));
+        std::cout << "caught " << e.what() << '\n';
     }
 
-    return std::move(std::get<2>(state.Data));
-}
-
-auto NewThread()
-{
-    return [](auto p) {
-        std::thread thread {[p = std::move(p)]() mutable { p.set_value(); }};
-        thread.detach();
-    };
-}
-
-template<typename Task>
-auto Async(Task task)
-{
-    return mc::Then(mc::NewThread(), [=] { return task(); });
-}
-}  // namespace mc
-
-int main()
-{
-    auto f  = mc::Async([] { return 42; });
-    auto f2 = mc::Then(f, [](auto i) { return i + i; });
-    std::cout << mc::SyncWait<int>(f2) << '\n';
     return 0;
-}
\ No newline at end of file
+}
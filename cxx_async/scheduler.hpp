@@ -0,0 +1,331 @@
+#pragma once
+
+#include "sender.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace mc
+{
+
+/**
+ * @brief Runs scheduled work right away, on the thread that starts it.
+ */
+struct InlineScheduler
+{
+    struct ScheduleSender
+    {
+        using value_type = void;
+
+        template<typename Receiver>
+        struct Op
+        {
+            Receiver receiver_;
+
+            auto start() noexcept -> void
+            {
+                if (GetStopToken(receiver_).stop_requested())
+                {
+                    receiver_.set_stopped();
+                }
+                else
+                {
+                    receiver_.set_value();
+                }
+            }
+        };
+
+        template<typename Receiver>
+        auto connect(Receiver r) const -> Op<Receiver>
+        {
+            return {std::move(r)};
+        }
+    };
+
+    [[nodiscard]] auto schedule() const noexcept -> ScheduleSender { return {}; }
+
+    friend auto operator==(InlineScheduler, InlineScheduler) noexcept -> bool { return true; }
+};
+
+/**
+ * @brief FIFO of scheduled work, drained by whoever calls Run().
+ *
+ * The queue is intrusive: every schedule() operation state carries its own
+ * links, so scheduling never allocates. Any number of threads may call Run()
+ * at once. Run() returns once Finish() was called and the queue is empty.
+ *
+ * If the receiver's stop token is stopped while the work is still queued, it
+ * is unlinked right away and completed with set_stopped on the thread that
+ * requested the stop, so it never occupies a worker.
+ */
+class RunLoop
+{
+    struct OpBase
+    {
+        OpBase* next {nullptr};
+        OpBase* prev {nullptr};
+        void (*execute)(OpBase*) noexcept;
+        bool queued {false};
+    };
+
+public:
+    class Scheduler;
+
+    RunLoop() = default;
+
+    RunLoop(RunLoop const&)                    = delete;
+    auto operator=(RunLoop const&) -> RunLoop& = delete;
+
+    [[nodiscard]] auto GetScheduler() noexcept -> Scheduler;
+
+    auto Run() -> void
+    {
+        while (auto* op = pop())
+        {
+            op->execute(op);
+        }
+    }
+
+    auto Finish() -> void
+    {
+        {
+            auto lock  = std::scoped_lock {mutex_};
+            finishing_ = true;
+        }
+        cv_.notify_all();
+    }
+
+private:
+    template<typename Receiver>
+    struct Op : OpBase
+    {
+        struct OnStop
+        {
+            Op* op_;
+
+            auto operator()() const noexcept -> void
+            {
+                if (op_->loop_->unlink(op_))
+                {
+                    op_->receiver_.set_stopped();
+                }
+            }
+        };
+
+        Op(RunLoop* loop, Receiver r) : OpBase {.execute = &Op::run}, loop_ {loop}, receiver_ {std::move(r)} {}
+
+        Op(Op const&)                    = delete;
+        auto operator=(Op const&) -> Op& = delete;
+
+        auto start() noexcept -> void
+        {
+            // The callback goes in before the push: once queued, a worker may
+            // complete and destroy this operation at any time.
+            auto token = GetStopToken(receiver_);
+            if (token.stop_possible())
+            {
+                onStop_.emplace(token, OnStop {this});
+            }
+            if (!loop_->push(this, token))
+            {
+                onStop_.reset();
+                receiver_.set_stopped();
+            }
+        }
+
+        static auto run(OpBase* base) noexcept -> void
+        {
+            auto& self = *static_cast<Op*>(base);
+            self.onStop_.reset();
+            if (GetStopToken(self.receiver_).stop_requested())
+            {
+                self.receiver_.set_stopped();
+            }
+            else
+            {
+                self.receiver_.set_value();
+            }
+        }
+
+        RunLoop* loop_;
+        Receiver receiver_;
+        std::optional<std::stop_callback<OnStop>> onStop_;
+    };
+
+    // Refuses work whose stop was already requested, so a stop that raced
+    // with start() is never left waiting in the queue.
+    auto push(OpBase* op, std::stop_token const& token) noexcept -> bool
+    {
+        {
+            auto lock = std::scoped_lock {mutex_};
+            if (token.stop_requested())
+            {
+                return false;
+            }
+
+            op->queued = true;
+            op->prev   = tail_;
+            if (tail_ == nullptr)
+            {
+                head_ = op;
+            }
+            else
+            {
+                tail_->next = op;
+            }
+            tail_ = op;
+        }
+        cv_.notify_one();
+        return true;
+    }
+
+    auto pop() -> OpBase*
+    {
+        auto lock = std::unique_lock {mutex_};
+        cv_.wait(lock, [this] { return head_ != nullptr || finishing_; });
+        auto* op = head_;
+        if (op != nullptr)
+        {
+            remove(op);
+        }
+        return op;
+    }
+
+    // True if op was still queued, i.e. the caller now owns its completion.
+    auto unlink(OpBase* op) noexcept -> bool
+    {
+        auto lock = std::scoped_lock {mutex_};
+        if (!op->queued)
+        {
+            return false;
+        }
+        remove(op);
+        return true;
+    }
+
+    auto remove(OpBase* op) noexcept -> void
+    {
+        (op->prev != nullptr ? op->prev->next : head_) = op->next;
+        (op->next != nullptr ? op->next->prev : tail_) = op->prev;
+        op->next   = nullptr;
+        op->prev   = nullptr;
+        op->queued = false;
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    OpBase* head_ {nullptr};
+    OpBase* tail_ {nullptr};
+    bool finishing_ {false};
+};
+
+class RunLoop::Scheduler
+{
+public:
+    struct ScheduleSender
+    {
+        using value_type = void;
+
+        RunLoop* loop_;
+
+        template<typename Receiver>
+        auto connect(Receiver r) const -> Op<Receiver>
+        {
+            return {loop_, std::move(r)};
+        }
+    };
+
+    explicit Scheduler(RunLoop* loop) noexcept : loop_ {loop} {}
+
+    [[nodiscard]] auto schedule() const noexcept -> ScheduleSender { return {loop_}; }
+
+    friend auto operator==(Scheduler, Scheduler) noexcept -> bool = default;
+
+private:
+    RunLoop* loop_;
+};
+
+inline auto RunLoop::GetScheduler() noexcept -> Scheduler { return Scheduler {this}; }
+
+/**
+ * @brief A fixed set of worker threads sharing one RunLoop.
+ *
+ * Threads are created once, in the constructor. Scheduling work only links
+ * its operation state into the queue. The destructor lets the workers drain
+ * what is already queued and joins them.
+ */
+class StaticThreadPool
+{
+public:
+    class Scheduler
+    {
+    public:
+        Scheduler(RunLoop::Scheduler loop, std::size_t concurrency) noexcept
+            : loop_ {loop}, concurrency_ {concurrency}
+        {
+        }
+
+        [[nodiscard]] auto schedule() const noexcept { return loop_.schedule(); }
+
+        // How many pieces parallel algorithms should split work into.
+        [[nodiscard]] auto Concurrency() const noexcept -> std::size_t { return concurrency_; }
+
+        friend auto operator==(Scheduler, Scheduler) noexcept -> bool = default;
+
+    private:
+        RunLoop::Scheduler loop_;
+        std::size_t concurrency_;
+    };
+
+    explicit StaticThreadPool(std::size_t threadCount = std::max(1U, std::thread::hardware_concurrency()))
+    {
+        workers_.reserve(threadCount);
+        for (std::size_t i = 0; i < threadCount; ++i)
+        {
+            workers_.emplace_back([this] { loop_.Run(); });
+        }
+    }
+
+    StaticThreadPool(StaticThreadPool const&)                    = delete;
+    auto operator=(StaticThreadPool const&) -> StaticThreadPool& = delete;
+
+    ~StaticThreadPool() { loop_.Finish(); }
+
+    [[nodiscard]] static auto GlobalInstance() -> StaticThreadPool&
+    {
+        static auto pool = StaticThreadPool {};
+        return pool;
+    }
+
+    [[nodiscard]] auto GetScheduler() noexcept -> Scheduler { return {loop_.GetScheduler(), workers_.size()}; }
+
+    [[nodiscard]] auto Size() const noexcept -> std::size_t { return workers_.size(); }
+
+private:
+    RunLoop loop_;
+    std::vector<std::jthread> workers_;
+};
+
+static_assert(mc::Scheduler<InlineScheduler>);
+static_assert(mc::Scheduler<RunLoop::Scheduler>);
+static_assert(mc::Scheduler<StaticThreadPool::Scheduler>);
+
+template<Scheduler Sched, typename Task>
+auto Async(Sched sched, Task&& task)
+{
+    return mc::Then(sched.schedule(), std::forward<Task>(task));
+}
+
+template<typename Task>
+auto Async(Task&& task)
+{
+    return mc::Async(StaticThreadPool::GlobalInstance().GetScheduler(), std::forward<Task>(task));
+}
+}  // namespace mc
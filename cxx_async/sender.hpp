@@ -0,0 +1,399 @@
+#pragma once
+
+#include <atomic>
+#include <concepts>
+#include <exception>
+#include <functional>
+#include <stop_token>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace mc
+{
+
+// A sender describes work that has not started yet. connect() hands it the
+// receiver that gets the result and returns an operation state, which does
+// nothing until start() is called. The operation state has to stay where it
+// is until it completes, so callers keep it on their stack (or inside their own
+// operation state) and adaptors nest the upstream state by value. The whole
+// chain is one object whose type is known at compile time, nothing is boxed.
+//
+// A receiver gets exactly one of set_value(value) (set_value() for void
+// senders), set_exception(std::exception_ptr) or set_stopped(). None of them
+// may throw. set_stopped means the work was abandoned because someone asked
+// for it: a receiver may offer get_stop_token(), adaptors hand it on
+// upstream, and schedulers and adaptors that see the stop request complete
+// with set_stopped instead of running the rest of the work.
+
+/**
+ * @brief Thrown by SyncWait and co_await when the operation was stopped.
+ */
+struct OperationStopped : std::exception
+{
+    [[nodiscard]] auto what() const noexcept -> char const* override { return "operation stopped"; }
+};
+
+/**
+ * @brief The receiver's stop token, or one that never stops.
+ */
+template<typename Receiver>
+auto GetStopToken(Receiver const& r) noexcept -> std::stop_token
+{
+    if constexpr (requires { r.get_stop_token(); })
+    {
+        return r.get_stop_token();
+    }
+    else
+    {
+        return {};
+    }
+}
+
+template<typename S>
+concept Sender = std::move_constructible<std::remove_cvref_t<S>>
+                 && requires { typename std::remove_cvref_t<S>::value_type; };
+
+template<typename S>
+using SenderValue = typename std::remove_cvref_t<S>::value_type;
+
+template<typename S, typename R>
+concept SenderTo = Sender<S> && requires(S&& s, R&& r) {
+    {
+        std::forward<S>(s).connect(std::forward<R>(r)).start()
+    } noexcept;
+};
+
+template<typename S>
+concept Scheduler = std::copy_constructible<S> && std::equality_comparable<S> && requires(S const& s) {
+    {
+        s.schedule()
+    } -> Sender;
+    requires std::is_void_v<SenderValue<decltype(s.schedule())>>;
+};
+
+namespace detail
+{
+
+// A continuation that cannot be called with the upstream value alone but
+// can with a std::stop_token after it gets the receiver's token, so long
+// running work can check whether it is still wanted.
+template<typename Cont, typename... Values>
+constexpr bool WantsStopToken = !std::is_invocable_v<Cont&, Values...>
+                                && std::is_invocable_v<Cont&, Values..., std::stop_token>;
+
+template<typename Cont, typename... Values>
+struct InvokeResult
+{
+    using type = std::invoke_result_t<Cont&, Values...>;
+};
+
+template<typename Cont, typename... Values>
+    requires WantsStopToken<Cont, Values...>
+struct InvokeResult<Cont, Values...>
+{
+    using type = std::invoke_result_t<Cont&, Values..., std::stop_token>;
+};
+
+template<typename Cont, typename T>
+struct ResultOf : InvokeResult<Cont, T>
+{
+};
+
+template<typename Cont>
+struct ResultOf<Cont, void> : InvokeResult<Cont>
+{
+};
+
+// Value storage that also works for void.
+template<typename T>
+using Stored = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+template<typename Receiver, typename Cont>
+struct ThenReceiver
+{
+    Receiver receiver_;
+    Cont cont_;
+
+    template<typename... Values>
+    auto set_value(Values&&... vs) noexcept -> void
+    {
+        auto token = GetStopToken(receiver_);
+        if (token.stop_requested())
+        {
+            receiver_.set_stopped();
+            return;
+        }
+
+        try
+        {
+            if constexpr (WantsStopToken<Cont, Values...>)
+            {
+                complete(std::forward<Values>(vs)..., std::move(token));
+            }
+            else
+            {
+                complete(std::forward<Values>(vs)...);
+            }
+        }
+        catch (...)
+        {
+            receiver_.set_exception(std::current_exception());
+        }
+    }
+
+    auto set_exception(std::exception_ptr e) noexcept -> void { receiver_.set_exception(std::move(e)); }
+
+    auto set_stopped() noexcept -> void { receiver_.set_stopped(); }
+
+    [[nodiscard]] auto get_stop_token() const noexcept -> std::stop_token { return GetStopToken(receiver_); }
+
+private:
+    template<typename... Args>
+    auto complete(Args&&... args) -> void
+    {
+        if constexpr (std::is_void_v<std::invoke_result_t<Cont&, Args...>>)
+        {
+            std::invoke(cont_, std::forward<Args>(args)...);
+            receiver_.set_value();
+        }
+        else
+        {
+            receiver_.set_value(std::invoke(cont_, std::forward<Args>(args)...));
+        }
+    }
+};
+
+template<typename Upstream, typename Cont>
+struct ThenSender
+{
+    using value_type = typename ResultOf<Cont, SenderValue<Upstream>>::type;
+
+    Upstream upstream_;
+    Cont cont_;
+
+    template<typename Receiver>
+    auto connect(Receiver r) &&
+    {
+        return std::move(upstream_).connect(ThenReceiver<Receiver, Cont> {std::move(r), std::move(cont_)});
+    }
+
+    template<typename Receiver>
+    auto connect(Receiver r) const&
+    {
+        return upstream_.connect(ThenReceiver<Receiver, Cont> {std::move(r), cont_});
+    }
+};
+
+// Runs the upstream operation and, once it completes, hops to the scheduler
+// before passing the result on. Both operations live inside this one.
+template<typename Upstream, typename Sched, typename Receiver>
+class TransferOp
+{
+public:
+    using value_type = SenderValue<Upstream>;
+
+    TransferOp(Upstream&& upstream, Sched const& sched, Receiver r)
+        : receiver_ {std::move(r)}
+        , upstreamOp_ {std::move(upstream).connect(UpstreamReceiver {this})}
+        , hopOp_ {sched.schedule().connect(HopReceiver {this})}
+    {
+    }
+
+    TransferOp(TransferOp const&)                    = delete;
+    auto operator=(TransferOp const&) -> TransferOp& = delete;
+
+    auto start() noexcept -> void { upstreamOp_.start(); }
+
+private:
+    struct UpstreamReceiver
+    {
+        TransferOp* op_;
+
+        template<typename... Values>
+        auto set_value(Values&&... vs) noexcept -> void
+        {
+            op_->data_.template emplace<2>(std::forward<Values>(vs)...);
+            op_->hopOp_.start();
+        }
+
+        auto set_exception(std::exception_ptr e) noexcept -> void
+        {
+            op_->data_.template emplace<1>(std::move(e));
+            op_->hopOp_.start();
+        }
+
+        auto set_stopped() noexcept -> void { op_->receiver_.set_stopped(); }
+
+        [[nodiscard]] auto get_stop_token() const noexcept -> std::stop_token { return GetStopToken(op_->receiver_); }
+    };
+
+    struct HopReceiver
+    {
+        TransferOp* op_;
+
+        auto set_value() noexcept -> void { op_->complete(); }
+
+        auto set_exception(std::exception_ptr e) noexcept -> void { op_->receiver_.set_exception(std::move(e)); }
+
+        auto set_stopped() noexcept -> void { op_->receiver_.set_stopped(); }
+
+        [[nodiscard]] auto get_stop_token() const noexcept -> std::stop_token { return GetStopToken(op_->receiver_); }
+    };
+
+    auto complete() noexcept -> void
+    {
+        if (data_.index() == 1)
+        {
+            receiver_.set_exception(std::move(std::get<1>(data_)));
+        }
+        else if constexpr (std::is_void_v<value_type>)
+        {
+            receiver_.set_value();
+        }
+        else
+        {
+            receiver_.set_value(std::move(std::get<2>(data_)));
+        }
+    }
+
+    using UpstreamOp = decltype(std::declval<Upstream>().connect(std::declval<UpstreamReceiver>()));
+    using HopOp      = decltype(std::declval<Sched const&>().schedule().connect(std::declval<HopReceiver>()));
+
+    Receiver receiver_;
+    std::variant<std::monostate, std::exception_ptr, Stored<value_type>> data_;
+    UpstreamOp upstreamOp_;
+    HopOp hopOp_;
+};
+
+template<typename Upstream, typename Sched>
+struct TransferSender
+{
+    using value_type = SenderValue<Upstream>;
+
+    Upstream upstream_;
+    Sched sched_;
+
+    template<typename Receiver>
+    auto connect(Receiver r) && -> TransferOp<Upstream, Sched, Receiver>
+    {
+        return {std::move(upstream_), sched_, std::move(r)};
+    }
+
+    template<typename Receiver>
+    auto connect(Receiver r) const& -> TransferOp<Upstream, Sched, Receiver>
+    {
+        return {Upstream {upstream_}, sched_, std::move(r)};
+    }
+};
+
+template<typename T>
+struct SyncWaitState
+{
+    std::atomic<bool> Done {false};
+    std::stop_token Token;
+    std::variant<std::monostate, std::exception_ptr, Stored<T>> Data;
+};
+
+template<typename T>
+struct SyncWaitReceiver
+{
+    SyncWaitState<T>* Pst;
+
+    template<std::size_t I, typename... V>
+    auto set(V&&... xs) noexcept -> void
+    {
+        // This receiver lives in the operation state on the waiter's stack,
+        // which may be gone as soon as Done is set. Only the local copy of the
+        // pointer is used from then on, and notify only hashes the address.
+        auto* state = Pst;
+        state->Data.template emplace<I>(std::forward<V>(xs)...);
+        state->Done.store(true, std::memory_order_release);
+        state->Done.notify_one();
+    }
+
+    template<typename... Values>
+    auto set_value(Values&&... vs) noexcept -> void
+    {
+        set<2>(std::forward<Values>(vs)...);
+    }
+
+    auto set_exception(std::exception_ptr e) noexcept -> void { set<1>(std::move(e)); }
+
+    auto set_stopped() noexcept -> void { set<0>(); }
+
+    [[nodiscard]] auto get_stop_token() const noexcept -> std::stop_token { return Pst->Token; }
+};
+}  // namespace detail
+
+struct Sink
+{
+    template<typename... Values>
+    auto set_value(Values&&... /*vs*/) noexcept -> void
+    {
+    }
+
+    auto set_exception(std::exception_ptr /*e*/) noexcept -> void { std::terminate(); }
+
+    auto set_stopped() noexcept -> void {}
+};
+
+template<Sender LazyFuture, typename Cont>
+auto Then(LazyFuture&& future, Cont&& cont)
+{
+    return detail::ThenSender<std::decay_t<LazyFuture>, std::decay_t<Cont>> {std::forward<LazyFuture>(future),
+                                                                            std::forward<Cont>(cont)};
+}
+
+/**
+ * @brief Completes on the given scheduler with the upstream result.
+ *
+ * `Then(Transfer(f, sched), cont)` runs cont on sched, wherever f finished.
+ */
+template<Sender LazyFuture, Scheduler Sched>
+auto Transfer(LazyFuture&& future, Sched sched)
+{
+    return detail::TransferSender<std::decay_t<LazyFuture>, Sched> {std::forward<LazyFuture>(future),
+                                                                   std::move(sched)};
+}
+
+/**
+ * @brief Starts the sender and blocks the calling thread until it completes.
+ *
+ * The operation state and the result slot live on this stack frame. Waiting
+ * is a std::atomic wait on a flag, i.e. a futex, not a mutex and condvar.
+ * The operation sees the given stop token. If it completes with set_stopped,
+ * OperationStopped is thrown.
+ */
+template<Sender LazyFuture>
+auto SyncWait(LazyFuture&& future, std::stop_token token = {}) -> SenderValue<LazyFuture>
+{
+    using T = SenderValue<LazyFuture>;
+
+    // State
+    detail::SyncWaitState<T> state;
+    state.Token = std::move(token);
+
+    // Launch the operation
+    auto op = std::forward<LazyFuture>(future).connect(detail::SyncWaitReceiver<T> {&state});
+    op.start();
+
+    // Wait
+    state.Done.wait(false, std::memory_order_acquire);
+
+    // Throw or Return
+    if (state.Data.index() == 0)
+    {
+        throw OperationStopped {};
+    }
+    if (state.Data.index() == 1)
+    {
+        std::rethrow_exception(std::get<1>(state.Data));
+    }
+
+    if constexpr (!std::is_void_v<T>)
+    {
+        return std::move(std::get<2>(state.Data));
+    }
+}
+}  // namespace mc
@@ -0,0 +1,510 @@
+#pragma once
+
+#include "sender.hpp"
+
+#include <array>
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <optional>
+#include <stop_token>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace mc
+{
+
+template<typename T = void>
+class Task;
+
+namespace detail
+{
+
+// Coroutine frames are created and destroyed at the rate tasks are, so
+// freed frames go onto a short per-thread list for their size class and
+// get reused from there instead of going back to malloc. A frame may be
+// freed on another thread than the one that allocated it, it then simply
+// moves to that thread's cache. Large frames bypass the cache.
+class FrameCache
+{
+public:
+    static constexpr std::size_t Granularity = 64;
+    static constexpr std::size_t ClassCount  = 16;
+    static constexpr std::size_t MaxCached   = 32;
+
+    static auto Allocate(std::size_t size) -> void*
+    {
+        auto const cls = sizeClass(size);
+        if (cls >= ClassCount)
+        {
+            return ::operator new(size);
+        }
+
+        if (auto& bin = bins[cls]; !closed && bin.head != nullptr)
+        {
+            auto* node = bin.head;
+            bin.head   = node->next;
+            --bin.count;
+            return node;
+        }
+
+        // Always the full class size, even once closed: the frame may be
+        // freed into this class on a thread whose cache is still open.
+        return ::operator new((cls + 1) * Granularity);
+    }
+
+    static auto Deallocate(void* ptr, std::size_t size) noexcept -> void
+    {
+        auto const cls = sizeClass(size);
+        if (cls < ClassCount && !closed && bins[cls].count < MaxCached)
+        {
+            auto& bin = bins[cls];
+            bin.head  = ::new (ptr) Node {bin.head};
+            ++bin.count;
+            return;
+        }
+        ::operator delete(ptr);
+    }
+
+private:
+    struct Node
+    {
+        Node* next;
+    };
+
+    struct Bin
+    {
+        Node* head;
+        std::size_t count;
+    };
+
+    // Returns everything to the heap at thread exit. Frames freed after that
+    // go straight to operator delete.
+    struct Drain
+    {
+        Drain() noexcept = default;
+
+        Drain(Drain const&)                    = delete;
+        auto operator=(Drain const&) -> Drain& = delete;
+
+        ~Drain()
+        {
+            closed = true;
+            for (auto& bin : bins)
+            {
+                while (auto* node = bin.head)
+                {
+                    bin.head = node->next;
+                    ::operator delete(node);
+                }
+                bin.count = 0;
+            }
+        }
+    };
+
+    static constexpr auto sizeClass(std::size_t size) noexcept -> std::size_t
+    {
+        return (size + Granularity - 1) / Granularity - 1;
+    }
+
+    static inline thread_local std::array<Bin, ClassCount> bins {};
+    static inline thread_local bool closed {false};
+    static inline thread_local Drain drain {};
+
+    friend struct FramePromise;
+};
+
+// Allocates coroutine frames from FrameCache.
+struct FramePromise
+{
+    static auto operator new(std::size_t size) -> void*
+    {
+        // Touch the drain so it is constructed, and thus destroyed, on every
+        // thread that caches frames.
+        static_cast<void>(&FrameCache::drain);
+        return FrameCache::Allocate(size);
+    }
+
+    static auto operator delete(void* ptr, std::size_t size) noexcept -> void { FrameCache::Deallocate(ptr, size); }
+};
+
+template<typename T>
+class TaskPromise;
+
+// co_await on a Task: the awaiting coroutine is parked as the continuation
+// and control transfers straight into the child, which transfers back from
+// its final suspend point. Neither step adds a stack frame, so arbitrarily
+// deep or long co_await chains run in constant stack.
+template<typename T>
+class TaskAwaiter
+{
+public:
+    explicit TaskAwaiter(std::coroutine_handle<TaskPromise<T>> child) noexcept : child_ {child} {}
+
+    TaskAwaiter(TaskAwaiter const&)                    = delete;
+    auto operator=(TaskAwaiter const&) -> TaskAwaiter& = delete;
+
+    ~TaskAwaiter()
+    {
+        if (child_)
+        {
+            child_.destroy();
+        }
+    }
+
+    [[nodiscard]] auto await_ready() const noexcept -> bool { return false; }
+
+    auto await_suspend(std::coroutine_handle<> parent) noexcept -> std::coroutine_handle<>
+    {
+        child_.promise().continuation_ = parent;
+        return child_;
+    }
+
+    auto await_resume() -> T { return child_.promise().result(); }
+
+private:
+    std::coroutine_handle<TaskPromise<T>> child_;
+};
+
+// co_await on any other sender: the operation state lives in the awaiter,
+// i.e. in the coroutine frame. If the sender completes before
+// await_suspend is done, the coroutine simply doesn't suspend, otherwise the
+// receiver resumes it. The sender sees the Task's stop token, and
+// set_stopped surfaces as an OperationStopped exception in the coroutine.
+template<typename S>
+class SenderAwaiter
+{
+    using value_type = SenderValue<S>;
+
+    struct Receiver
+    {
+        SenderAwaiter* self_;
+
+        template<typename... Values>
+        auto set_value(Values&&... vs) noexcept -> void
+        {
+            self_->result_.template emplace<2>(std::forward<Values>(vs)...);
+            self_->arrive();
+        }
+
+        auto set_exception(std::exception_ptr e) noexcept -> void
+        {
+            self_->result_.template emplace<1>(std::move(e));
+            self_->arrive();
+        }
+
+        auto set_stopped() noexcept -> void
+        {
+            self_->result_.template emplace<1>(std::make_exception_ptr(OperationStopped {}));
+            self_->arrive();
+        }
+
+        [[nodiscard]] auto get_stop_token() const noexcept -> std::stop_token { return self_->token_; }
+    };
+
+    using Op = decltype(std::declval<S>().connect(std::declval<Receiver>()));
+
+public:
+    SenderAwaiter(S&& sender, std::stop_token token)
+        : token_ {std::move(token)}, op_ {std::forward<S>(sender).connect(Receiver {this})}
+    {
+    }
+
+    SenderAwaiter(SenderAwaiter const&)                    = delete;
+    auto operator=(SenderAwaiter const&) -> SenderAwaiter& = delete;
+
+    [[nodiscard]] auto await_ready() const noexcept -> bool { return false; }
+
+    auto await_suspend(std::coroutine_handle<> h) noexcept -> bool
+    {
+        continuation_ = h;
+        op_.start();
+        return !arrived_.exchange(true, std::memory_order_acq_rel);
+    }
+
+    auto await_resume() -> value_type
+    {
+        if (result_.index() == 1)
+        {
+            std::rethrow_exception(std::get<1>(result_));
+        }
+        if constexpr (!std::is_void_v<value_type>)
+        {
+            return std::move(std::get<2>(result_));
+        }
+    }
+
+private:
+    // Whoever comes second, the receiver or await_suspend, continues.
+    auto arrive() noexcept -> void
+    {
+        if (arrived_.exchange(true, std::memory_order_acq_rel))
+        {
+            continuation_.resume();
+        }
+    }
+
+    std::variant<std::monostate, std::exception_ptr, Stored<value_type>> result_;
+    std::coroutine_handle<> continuation_;
+    std::atomic<bool> arrived_ {false};
+    std::stop_token token_;
+    Op op_;
+};
+
+template<typename T>
+struct IsTask : std::false_type
+{
+};
+
+template<typename T>
+struct IsTask<Task<T>> : std::true_type
+{
+};
+
+class TaskPromiseBase : public FramePromise
+{
+public:
+    struct FinalAwaiter
+    {
+        [[nodiscard]] auto await_ready() const noexcept -> bool { return false; }
+
+        template<typename Promise>
+        auto await_suspend(std::coroutine_handle<Promise> h) noexcept -> std::coroutine_handle<>
+        {
+            auto& p = h.promise();
+            if (p.complete_ != nullptr)
+            {
+                // Started as a sender. The receiver may destroy the frame,
+                // so nothing here touches it afterwards.
+                p.complete_(p.context_);
+                return std::noop_coroutine();
+            }
+            return p.continuation_;
+        }
+
+        auto await_resume() const noexcept -> void {}
+    };
+
+    [[nodiscard]] auto initial_suspend() const noexcept -> std::suspend_always { return {}; }
+
+    [[nodiscard]] auto final_suspend() const noexcept -> FinalAwaiter { return {}; }
+
+    auto unhandled_exception() noexcept -> void { error_ = std::current_exception(); }
+
+    template<typename U>
+    auto await_transform(U&& awaitable) -> decltype(auto)
+    {
+        using Plain = std::remove_cvref_t<U>;
+        if constexpr (IsTask<Plain>::value)
+        {
+            static_assert(!std::is_lvalue_reference_v<U>, "co_await a Task by value: co_await std::move(task)");
+            auto child             = std::forward<U>(awaitable).release();
+            child.promise().token_ = token_;
+            return TaskAwaiter<typename Plain::value_type> {child};
+        }
+        else if constexpr (Sender<Plain>)
+        {
+            return SenderAwaiter<U> {std::forward<U>(awaitable), token_};
+        }
+        else
+        {
+            return std::forward<U>(awaitable);
+        }
+    }
+
+protected:
+    template<typename T>
+    friend class TaskAwaiter;
+
+    template<typename T, typename Receiver>
+    friend class TaskOp;
+
+    std::coroutine_handle<> continuation_ {std::noop_coroutine()};
+    void (*complete_)(void*) noexcept {nullptr};
+    void* context_ {nullptr};
+    std::exception_ptr error_;
+    std::stop_token token_;
+};
+
+template<typename T>
+class TaskPromise : public TaskPromiseBase
+{
+public:
+    auto get_return_object() noexcept -> Task<T>;
+
+    template<typename U>
+        requires std::convertible_to<U, T>
+    auto return_value(U&& value) -> void
+    {
+        value_.emplace(std::forward<U>(value));
+    }
+
+    auto result() -> T
+    {
+        if (error_)
+        {
+            std::rethrow_exception(error_);
+        }
+        return std::move(*value_);
+    }
+
+private:
+    template<typename U, typename Receiver>
+    friend class TaskOp;
+
+    std::optional<T> value_;
+};
+
+template<>
+class TaskPromise<void> : public TaskPromiseBase
+{
+public:
+    auto get_return_object() noexcept -> Task<void>;
+
+    auto return_void() noexcept -> void {}
+
+    auto result() -> void
+    {
+        if (error_)
+        {
+            std::rethrow_exception(error_);
+        }
+    }
+};
+
+// A Task connected to a receiver. Owns the frame from here on.
+template<typename T, typename Receiver>
+class TaskOp
+{
+public:
+    TaskOp(std::coroutine_handle<TaskPromise<T>> h, Receiver r) noexcept : handle_ {h}, receiver_ {std::move(r)} {}
+
+    TaskOp(TaskOp const&)                    = delete;
+    auto operator=(TaskOp const&) -> TaskOp& = delete;
+
+    ~TaskOp()
+    {
+        if (handle_)
+        {
+            handle_.destroy();
+        }
+    }
+
+    auto start() noexcept -> void
+    {
+        auto& p     = handle_.promise();
+        p.complete_ = &TaskOp::complete;
+        p.context_  = this;
+        p.token_    = GetStopToken(receiver_);
+        handle_.resume();
+    }
+
+private:
+    static auto complete(void* context) noexcept -> void
+    {
+        auto& self = *static_cast<TaskOp*>(context);
+        auto& p    = self.handle_.promise();
+        if (p.error_)
+        {
+            // A stop that nobody in the coroutine handled goes out as such.
+            try
+            {
+                std::rethrow_exception(p.error_);
+            }
+            catch (OperationStopped const&)
+            {
+                self.receiver_.set_stopped();
+            }
+            catch (...)
+            {
+                self.receiver_.set_exception(p.error_);
+            }
+        }
+        else if constexpr (std::is_void_v<T>)
+        {
+            self.receiver_.set_value();
+        }
+        else
+        {
+            self.receiver_.set_value(std::move(*p.value_));
+        }
+    }
+
+    std::coroutine_handle<TaskPromise<T>> handle_;
+    Receiver receiver_;
+};
+}  // namespace detail
+
+/**
+ * @brief Lazily started coroutine producing a T.
+ *
+ * Inside a Task, co_await works on other Tasks (by symmetric transfer) and
+ * on any sender, e.g. `co_await mc::Async(sched, f)`. A Task is itself a
+ * sender, so `mc::SyncWait(Coro())` or `mc::Then(Coro(), f)` work as
+ * expected. Frames come from a per-thread recycling cache.
+ */
+template<typename T>
+class [[nodiscard]] Task
+{
+    static_assert(!std::is_reference_v<T>, "Task<T&> is not supported");
+
+public:
+    using value_type   = T;
+    using promise_type = detail::TaskPromise<T>;
+
+    Task(Task&& other) noexcept : handle_ {std::exchange(other.handle_, {})} {}
+
+    auto operator=(Task&& other) noexcept -> Task&
+    {
+        if (this != &other)
+        {
+            reset();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+
+    ~Task() { reset(); }
+
+    template<typename Receiver>
+    auto connect(Receiver r) && noexcept -> detail::TaskOp<T, Receiver>
+    {
+        return {release(), std::move(r)};
+    }
+
+private:
+    friend class detail::TaskPromise<T>;
+    friend class detail::TaskPromiseBase;
+
+    explicit Task(std::coroutine_handle<promise_type> h) noexcept : handle_ {h} {}
+
+    auto release() noexcept -> std::coroutine_handle<promise_type> { return std::exchange(handle_, {}); }
+
+    auto reset() noexcept -> void
+    {
+        if (handle_)
+        {
+            std::exchange(handle_, {}).destroy();
+        }
+    }
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+namespace detail
+{
+template<typename T>
+auto TaskPromise<T>::get_return_object() noexcept -> Task<T>
+{
+    return Task<T> {std::coroutine_handle<TaskPromise<T>>::from_promise(*this)};
+}
+
+inline auto TaskPromise<void>::get_return_object() noexcept -> Task<void>
+{
+    return Task<void> {std::coroutine_handle<TaskPromise<void>>::from_promise(*this)};
+}
+}  // namespace detail
+}  // namespace mc
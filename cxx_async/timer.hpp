@@ -0,0 +1,225 @@
+#pragma once
+
+#include "sender.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace mc
+{
+
+/**
+ * @brief One thread that completes senders at given points in time.
+ *
+ * At(tp) and After(d) are void senders that complete on the timer thread.
+ * Pending timers sit in a min-heap of pointers to their operation states.
+ * Stopping a pending timer takes it out of the heap right away and completes
+ * it with set_stopped on the thread that requested the stop.
+ */
+class TimerService
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct TimerBase
+    {
+        Clock::time_point deadline;
+        void (*fire)(TimerBase*) noexcept;
+        bool queued {false};
+    };
+
+public:
+    TimerService() : worker_ {[this] { run(); }} {}
+
+    TimerService(TimerService const&)                    = delete;
+    auto operator=(TimerService const&) -> TimerService& = delete;
+
+    ~TimerService()
+    {
+        {
+            auto lock = std::scoped_lock {mutex_};
+            stop_     = true;
+        }
+        cv_.notify_one();
+    }
+
+    [[nodiscard]] static auto GlobalInstance() -> TimerService&
+    {
+        static auto service = TimerService {};
+        return service;
+    }
+
+    template<typename Receiver>
+    class Op : TimerBase
+    {
+    public:
+        Op(TimerService* service, Clock::time_point due, Receiver r)
+            : TimerBase {due, &Op::run}, service_ {service}, receiver_ {std::move(r)}
+        {
+        }
+
+        Op(Op const&)                    = delete;
+        auto operator=(Op const&) -> Op& = delete;
+
+        auto start() noexcept -> void
+        {
+            auto token = GetStopToken(receiver_);
+            if (token.stop_possible())
+            {
+                onStop_.emplace(token, OnStop {this});
+            }
+            if (!service_->add(this, token))
+            {
+                onStop_.reset();
+                receiver_.set_stopped();
+            }
+        }
+
+    private:
+        struct OnStop
+        {
+            Op* op_;
+
+            auto operator()() const noexcept -> void
+            {
+                if (op_->service_->remove(op_))
+                {
+                    op_->receiver_.set_stopped();
+                }
+            }
+        };
+
+        static auto run(TimerBase* base) noexcept -> void
+        {
+            auto& self = *static_cast<Op*>(base);
+            self.onStop_.reset();
+            self.receiver_.set_value();
+        }
+
+        TimerService* service_;
+        Receiver receiver_;
+        std::optional<std::stop_callback<OnStop>> onStop_;
+    };
+
+    struct AtSender
+    {
+        using value_type = void;
+
+        TimerService* service_;
+        Clock::time_point deadline_;
+
+        template<typename Receiver>
+        auto connect(Receiver r) const -> Op<Receiver>
+        {
+            return {service_, deadline_, std::move(r)};
+        }
+    };
+
+    // The delay counts from connect(), which is right before start().
+    struct AfterSender
+    {
+        using value_type = void;
+
+        TimerService* service_;
+        Clock::duration delay_;
+
+        template<typename Receiver>
+        auto connect(Receiver r) const -> Op<Receiver>
+        {
+            return {service_, Clock::now() + delay_, std::move(r)};
+        }
+    };
+
+    [[nodiscard]] auto At(Clock::time_point deadline) noexcept -> AtSender { return {this, deadline}; }
+
+    template<class Rep, class Period>
+    [[nodiscard]] auto After(std::chrono::duration<Rep, Period> const& delay) -> AfterSender
+    {
+        return {this, std::chrono::ceil<Clock::duration>(delay)};
+    }
+
+private:
+    static auto later(TimerBase const* a, TimerBase const* b) noexcept -> bool { return a->deadline > b->deadline; }
+
+    auto add(TimerBase* timer, std::stop_token const& token) -> bool
+    {
+        auto first = false;
+        {
+            auto lock = std::scoped_lock {mutex_};
+            if (token.stop_requested())
+            {
+                return false;
+            }
+
+            timer->queued = true;
+            timers_.push_back(timer);
+            std::push_heap(timers_.begin(), timers_.end(), later);
+            first = timers_.front() == timer;
+        }
+
+        // Only a new earliest deadline changes how long the thread sleeps.
+        if (first)
+        {
+            cv_.notify_one();
+        }
+        return true;
+    }
+
+    // True if the timer was still pending and is now the caller's to complete.
+    auto remove(TimerBase* timer) noexcept -> bool
+    {
+        auto lock = std::scoped_lock {mutex_};
+        if (!timer->queued)
+        {
+            return false;
+        }
+
+        timer->queued = false;
+        std::erase(timers_, timer);
+        std::make_heap(timers_.begin(), timers_.end(), later);
+        return true;
+    }
+
+    auto run() -> void
+    {
+        auto lock = std::unique_lock {mutex_};
+        while (!stop_)
+        {
+            if (timers_.empty())
+            {
+                cv_.wait(lock);
+                continue;
+            }
+
+            // By value: the timer may be stopped and gone while we sleep.
+            auto* next        = timers_.front();
+            auto const wakeup = next->deadline;
+            if (Clock::now() < wakeup)
+            {
+                cv_.wait_until(lock, wakeup);
+                continue;
+            }
+
+            std::pop_heap(timers_.begin(), timers_.end(), later);
+            timers_.pop_back();
+            next->queued = false;
+
+            lock.unlock();
+            next->fire(next);
+            lock.lock();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<TimerBase*> timers_;
+    bool stop_ {false};
+    std::jthread worker_;
+};
+}  // namespace mc
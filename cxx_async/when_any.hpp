@@ -0,0 +1,198 @@
+#pragma once
+
+#include "sender.hpp"
+#include "timer.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <stdexcept>
+#include <stop_token>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace mc
+{
+
+/**
+ * @brief The error WithTimeout completes with when time runs out first.
+ */
+struct TimedOut : std::runtime_error
+{
+    TimedOut() : std::runtime_error {"operation timed out"} {}
+};
+
+namespace detail
+{
+
+template<typename Op, std::size_t I, typename S>
+class WhenAnyChild
+{
+    struct Receiver
+    {
+        Op* op_;
+
+        template<typename... Values>
+        auto set_value(Values&&... vs) noexcept -> void
+        {
+            op_->template arrive<2>(std::forward<Values>(vs)...);
+        }
+
+        auto set_exception(std::exception_ptr e) noexcept -> void { op_->template arrive<1>(std::move(e)); }
+
+        auto set_stopped() noexcept -> void { op_->finish(); }
+
+        [[nodiscard]] auto get_stop_token() const noexcept -> std::stop_token { return op_->source_.get_token(); }
+    };
+
+public:
+    WhenAnyChild(Op* op, S&& sender) : childOp_ {std::move(sender).connect(Receiver {op})} {}
+
+    auto StartChild() noexcept -> void { childOp_.start(); }
+
+private:
+    decltype(std::declval<S>().connect(std::declval<Receiver>())) childOp_;
+};
+
+// All children run at once. The first value or exception wins and requests
+// stop on the others through a stop source their receivers hand out. The
+// result goes downstream once every child has completed, so no child
+// outlives the operation. A stop request from downstream is forwarded to
+// the same source.
+template<typename Receiver, typename Indices, typename... Ss>
+class WhenAnyOp;
+
+template<typename Receiver, std::size_t... Is, typename... Ss>
+class WhenAnyOp<Receiver, std::index_sequence<Is...>, Ss...> : WhenAnyChild<WhenAnyOp<Receiver, std::index_sequence<Is...>, Ss...>, Is, Ss>...
+{
+    template<typename Op, std::size_t I, typename S>
+    friend class WhenAnyChild;
+
+    using value_type = std::common_type_t<SenderValue<Ss>...>;
+
+    struct ForwardStop
+    {
+        std::stop_source* source_;
+
+        auto operator()() const noexcept -> void { source_->request_stop(); }
+    };
+
+public:
+    WhenAnyOp(std::tuple<Ss...>&& senders, Receiver r)
+        : WhenAnyChild<WhenAnyOp, Is, Ss>(this, std::get<Is>(std::move(senders)))...
+        , receiver_ {std::move(r)}
+    {
+    }
+
+    WhenAnyOp(WhenAnyOp const&)                    = delete;
+    auto operator=(WhenAnyOp const&) -> WhenAnyOp& = delete;
+
+    auto start() noexcept -> void
+    {
+        if (auto token = GetStopToken(receiver_); token.stop_possible())
+        {
+            onStop_.emplace(std::move(token), ForwardStop {&source_});
+        }
+        (static_cast<WhenAnyChild<WhenAnyOp, Is, Ss>&>(*this).StartChild(), ...);
+    }
+
+private:
+    template<std::size_t Which, typename... Values>
+    auto arrive(Values&&... vs) noexcept -> void
+    {
+        if (!won_.exchange(true, std::memory_order_relaxed))
+        {
+            result_.template emplace<Which>(std::forward<Values>(vs)...);
+            source_.request_stop();
+        }
+        finish();
+    }
+
+    auto finish() noexcept -> void
+    {
+        if (remaining_.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        {
+            return;
+        }
+
+        onStop_.reset();
+        if (result_.index() == 1)
+        {
+            receiver_.set_exception(std::move(std::get<1>(result_)));
+        }
+        else if (result_.index() == 0)
+        {
+            receiver_.set_stopped();
+        }
+        else if constexpr (std::is_void_v<value_type>)
+        {
+            receiver_.set_value();
+        }
+        else
+        {
+            receiver_.set_value(std::move(std::get<2>(result_)));
+        }
+    }
+
+    Receiver receiver_;
+    std::stop_source source_;
+    std::optional<std::stop_callback<ForwardStop>> onStop_;
+    std::variant<std::monostate, std::exception_ptr, Stored<value_type>> result_;
+    std::atomic<bool> won_ {false};
+    std::atomic<std::size_t> remaining_ {sizeof...(Ss)};
+};
+
+template<typename... Ss>
+struct WhenAnySender
+{
+    using value_type = std::common_type_t<SenderValue<Ss>...>;
+
+    std::tuple<Ss...> senders_;
+
+    template<typename Receiver>
+    auto connect(Receiver r) && -> WhenAnyOp<Receiver, std::index_sequence_for<Ss...>, Ss...>
+    {
+        return {std::move(senders_), std::move(r)};
+    }
+
+    template<typename Receiver>
+    auto connect(Receiver r) const& -> WhenAnyOp<Receiver, std::index_sequence_for<Ss...>, Ss...>
+    {
+        return {std::tuple<Ss...> {senders_}, std::move(r)};
+    }
+};
+}  // namespace detail
+
+/**
+ * @brief Runs all senders, completes with whichever finishes first and stops
+ * the rest.
+ *
+ * The first value or exception wins; set_stopped from a child never does.
+ * If every child stops, so does WhenAny. All senders need a common value
+ * type. Completion waits until the losers have acknowledged the stop, which
+ * takes as long as they take to notice it.
+ */
+template<Sender... LazyFutures>
+    requires(sizeof...(LazyFutures) > 0)
+auto WhenAny(LazyFutures&&... futures)
+{
+    return detail::WhenAnySender<std::decay_t<LazyFutures>...> {{std::forward<LazyFutures>(futures)...}};
+}
+
+/**
+ * @brief Completes like the sender, or with TimedOut if it takes longer than
+ * the given time, in which case the sender is stopped.
+ */
+template<Sender LazyFuture, class Rep, class Period>
+auto WithTimeout(LazyFuture&& future, std::chrono::duration<Rep, Period> const& timeout,
+                 TimerService& timers = TimerService::GlobalInstance())
+{
+    using T = SenderValue<LazyFuture>;
+    return mc::WhenAny(std::forward<LazyFuture>(future),
+                       mc::Then(timers.After(timeout), []() -> T { throw TimedOut {}; }));
+}
+}  // namespace mc
@@ -0,0 +1,50 @@
+#include "suites.hpp"
+
+#include "dft.hpp"
+
+#include <cstddef>
+
+#include <complex>
+#include <numbers>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+template<typename T>
+auto MakeSignal(std::size_t size) -> std::vector<std::complex<T>>
+{
+    auto signal = std::vector<std::complex<T>>(size);
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        auto const phase = T {2} * std::numbers::pi_v<T> * T {3} * static_cast<T>(i) / static_cast<T>(size);
+        signal[i]        = {std::cos(phase), T {0}};
+    }
+    return signal;
+}
+
+template<typename T>
+auto Run(mc::Benchmark& bench, char const* type, std::size_t size) -> void
+{
+    auto const input = MakeSignal<T>(size);
+    auto output      = std::vector<std::complex<T>>(size);
+
+    auto const name = std::string {"dft/"} + type + "/" + std::to_string(size);
+    bench.Run(name, [&] {
+        discreteFourierTransform<T>(input, output);
+        mc::DoNotOptimizeAway(output.data());
+        mc::ClobberMemory();
+    });
+}
+
+}  // namespace
+
+auto BenchDft(mc::Benchmark& bench) -> void
+{
+    for (auto const size : {std::size_t {64}, std::size_t {256}, std::size_t {1024}})
+    {
+        Run<float>(bench, "float", size);
+        Run<double>(bench, "double", size);
+    }
+}
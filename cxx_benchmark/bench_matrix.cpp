@@ -0,0 +1,58 @@
+#include "suites.hpp"
+
+#include "matrix.hpp"
+#include "vector.hpp"
+
+#include <cstdint>
+
+#include <string>
+
+namespace
+{
+
+// Diagonally dominant, so inverse() never meets a singular pivot.
+auto MakeMatrix(std::uint32_t size) -> math::Matrix<double>
+{
+    auto mat = math::Matrix<double> {size, size};
+    for (std::uint32_t row = 0; row < size; ++row)
+    {
+        for (std::uint32_t col = 0; col < size; ++col)
+        {
+            mat(row, col) = row == col ? double(size) : 1.0 / (1.0 + row + col);
+        }
+    }
+    return mat;
+}
+
+auto MakeVector(std::uint32_t size) -> math::Vector<double>
+{
+    auto vec = math::Vector<double> {size};
+    for (std::uint32_t i = 0; i < size; ++i)
+    {
+        vec[i] = 1.0 + i;
+    }
+    return vec;
+}
+
+}  // namespace
+
+auto BenchMatrix(mc::Benchmark& bench) -> void
+{
+    for (auto const size : {std::uint32_t {16}, std::uint32_t {64}, std::uint32_t {256}})
+    {
+        auto const mat = MakeMatrix(size);
+        auto const vec = MakeVector(size);
+        bench.Run("matrix/mul_vector/" + std::to_string(size), [&] { mc::DoNotOptimizeAway(mat * vec); });
+        bench.Run("matrix/add/" + std::to_string(size), [&] { mc::DoNotOptimizeAway(mat + mat); });
+    }
+
+    for (auto const size : {std::uint32_t {16}, std::uint32_t {64}})
+    {
+        auto const mat = MakeMatrix(size);
+        bench.Run("matrix/inverse/" + std::to_string(size), [&] { mc::DoNotOptimizeAway(math::inverse(mat)); });
+    }
+
+    // Laplace expansion, O(n!).
+    auto const small = MakeMatrix(7);
+    bench.Run("matrix/determinant/7", [&] { mc::DoNotOptimizeAway(math::determinant(small)); });
+}
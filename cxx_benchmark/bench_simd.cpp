@@ -0,0 +1,93 @@
+#include "suites.hpp"
+
+#include "simd_256.hpp"
+
+#include <cstddef>
+
+#include <string>
+#include <vector>
+
+// Built with -mavx2 -mfma. main() only calls in here after checking that the
+// CPU has both.
+
+namespace
+{
+
+auto ScalarSaxpy(float a, float const* x, float* y, std::size_t size) -> void
+{
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        y[i] = a * x[i] + y[i];
+    }
+}
+
+auto SimdSaxpy(float a, float const* x, float* y, std::size_t size) -> void
+{
+    auto const va = simd::loadValue(a);
+    for (std::size_t i = 0; i < size; i += 8)
+    {
+        simd::storeTo(y + i, simd::fusedMultiplyAdd(va, simd::loadFrom(x + i), simd::loadFrom(y + i)));
+    }
+}
+
+// Without -ffast-math the compiler has to keep the additions in order, so
+// this one is not vectorised.
+auto ScalarDot(float const* x, float const* y, std::size_t size) -> float
+{
+    auto sum = 0.0F;
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        sum += x[i] * y[i];
+    }
+    return sum;
+}
+
+// Four independent accumulators to hide the FMA latency.
+auto SimdDot(float const* x, float const* y, std::size_t size) -> float
+{
+    auto acc0 = simd::loadValue(0.0F);
+    auto acc1 = acc0;
+    auto acc2 = acc0;
+    auto acc3 = acc0;
+    for (std::size_t i = 0; i < size; i += 32)
+    {
+        acc0 = simd::fusedMultiplyAdd(simd::loadFrom(x + i), simd::loadFrom(y + i), acc0);
+        acc1 = simd::fusedMultiplyAdd(simd::loadFrom(x + i + 8), simd::loadFrom(y + i + 8), acc1);
+        acc2 = simd::fusedMultiplyAdd(simd::loadFrom(x + i + 16), simd::loadFrom(y + i + 16), acc2);
+        acc3 = simd::fusedMultiplyAdd(simd::loadFrom(x + i + 24), simd::loadFrom(y + i + 24), acc3);
+    }
+
+    float lanes[8];
+    simd::storeTo(lanes, simd::add(simd::add(acc0, acc1), simd::add(acc2, acc3)));
+
+    auto sum = 0.0F;
+    for (auto const lane : lanes)
+    {
+        sum += lane;
+    }
+    return sum;
+}
+
+}  // namespace
+
+auto BenchSimd(mc::Benchmark& bench) -> void
+{
+    // Multiples of 32 for SimdDot. The largest one does not fit into L2.
+    for (auto const size : {std::size_t {1024}, std::size_t {16 * 1024}, std::size_t {1024 * 1024}})
+    {
+        auto const x = std::vector<float>(size, 0.5F);
+        auto y       = std::vector<float>(size, 0.25F);
+        auto const n = std::to_string(size);
+
+        bench.Run("simd/saxpy/scalar/" + n, [&] {
+            ScalarSaxpy(0.999F, x.data(), y.data(), size);
+            mc::ClobberMemory();
+        });
+        bench.Run("simd/saxpy/avx2/" + n, [&] {
+            SimdSaxpy(0.999F, x.data(), y.data(), size);
+            mc::ClobberMemory();
+        });
+        bench.Run("simd/dot/scalar/" + n, [&] { mc::DoNotOptimizeAway(ScalarDot(x.data(), y.data(), size)); });
+        bench.Run("simd/dot/avx2/" + n, [&] { mc::DoNotOptimizeAway(SimdDot(x.data(), y.data(), size)); });
+    }
+}
@@ -0,0 +1,72 @@
+#include "suites.hpp"
+
+#include "parallel.hpp"
+#include "pool.hpp"
+
+#include <cmath>
+#include <cstddef>
+
+#include <numeric>
+#include <ranges>
+#include <vector>
+
+namespace
+{
+
+constexpr auto Tasks = std::size_t {1'000};
+
+auto Spin(std::size_t n) -> void
+{
+    for (auto i = 0; i < 1'000; ++i)
+    {
+        mc::DoNotOptimizeAway(i);
+    }
+    mc::DoNotOptimizeAway(n);
+}
+
+}  // namespace
+
+auto BenchThreadPool(mc::Benchmark& bench) -> void
+{
+    auto& pool = mc::ThreadPool::GlobalInstance();
+
+    bench.Run("thread_pool/async_get", [] { mc::DoNotOptimizeAway(mc::Async([] { return 42; }).get()); });
+
+    auto const taskGroup = [](mc::ThreadPool& p) {
+        auto group = mc::TaskGroup {p};
+        for (std::size_t i = 0; i < 64; ++i)
+        {
+            group.Run([i] { Spin(i); });
+        }
+        group.Wait();
+    };
+    bench.Run("thread_pool/task_group/64", [&] { taskGroup(pool); });
+
+    // Same pool size, with ThreadPoolOptions::metrics on.
+    {
+        auto options        = mc::ThreadPoolOptions {};
+        options.threadCount = pool.Size();
+        options.metrics     = true;
+        auto metered        = mc::ThreadPool {options};
+        bench.Run("thread_pool/task_group/64/metrics", [&] { taskGroup(metered); });
+    }
+
+    bench.Run("thread_pool/for/serial", [] {
+        for (std::size_t i = 0; i < Tasks; ++i)
+        {
+            Spin(i);
+        }
+    });
+    bench.Run("thread_pool/for/parallel_for",
+              [] { mc::parallel_for(std::views::iota(std::size_t {0}, Tasks), Spin); });
+
+    auto const values   = std::vector<double>(1 << 20, 2.0);
+    auto const sqrtPlus = [](double acc, double v) { return acc + std::sqrt(v); };
+    bench.Run("thread_pool/reduce/serial", [&] {
+        mc::DoNotOptimizeAway(std::accumulate(values.begin(), values.end(), 0.0, sqrtPlus));
+    });
+    bench.Run("thread_pool/reduce/parallel_reduce", [&] {
+        auto const leafSqrt = std::views::transform(values, [](double v) { return std::sqrt(v); });
+        mc::DoNotOptimizeAway(mc::parallel_reduce(leafSqrt, 0.0));
+    });
+}
@@ -0,0 +1,547 @@
+#pragma once
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+#if defined(__linux__)
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Statistical microbenchmarks. Each benchmark is warmed up, its iteration
+// count is calibrated so that one sample takes about --sample-ms, and the
+// samples are summarised as median, median absolute deviation and minimum
+// per iteration:
+//
+//   auto bench = mc::Benchmark {argc, argv};
+//   bench.Run("dft/1024", [&] { mc::DoNotOptimizeAway(Transform(input)); });
+//   return bench.Finish();
+//
+// With --counters, cycles, instructions and cache misses of the calling
+// thread are read through perf_event_open. --json writes all results to a
+// file that can be diffed against an earlier run.
+
+namespace mc
+{
+
+#if defined(_MSC_VER)
+
+    #pragma optimize("", off)
+inline auto DoNotOptimizeDependencySink(void const*) -> void { }
+    #pragma optimize("", on)
+
+/**
+ * @brief Keeps the compiler from discarding a value that is never read.
+ */
+template<typename T>
+auto DoNotOptimizeAway(T const& datum) -> void
+{
+    DoNotOptimizeDependencySink(&datum);
+}
+
+/**
+ * @brief Keeps the compiler from sinking stores past this point.
+ */
+inline auto ClobberMemory() -> void { _ReadWriteBarrier(); }
+
+#else
+
+/**
+ * @brief Keeps the compiler from discarding a value that is never read.
+ */
+template<typename T>
+auto DoNotOptimizeAway(T const& datum) -> void
+{
+    // The asm block reads datum from memory and may read or write any other
+    // memory location.
+    asm volatile("" ::"m"(datum) : "memory");
+}
+
+/**
+ * @brief Keeps the compiler from sinking stores past this point.
+ */
+inline auto ClobberMemory() -> void { asm volatile("" ::: "memory"); }
+
+#endif
+
+/**
+ * @brief Hardware counters of one benchmark, per iteration.
+ */
+struct BenchmarkCounters
+{
+    double cycles {0};
+    double instructions {0};
+    double cacheMisses {0};
+};
+
+/**
+ * @brief Summary of one benchmark. Times are nanoseconds per iteration.
+ */
+struct BenchmarkResult
+{
+    std::string name;
+    std::uint64_t iterations {0};  ///< per sample
+    std::size_t samples {0};
+    double median {0};
+    double mad {0};
+    double min {0};
+    std::optional<BenchmarkCounters> counters;
+};
+
+/**
+ * @brief How long to warm up and sample, and what to report.
+ */
+struct BenchmarkOptions
+{
+    std::chrono::nanoseconds warmup {std::chrono::milliseconds {100}};
+    std::chrono::nanoseconds sampleTime {std::chrono::milliseconds {10}};
+    std::chrono::nanoseconds maxTime {std::chrono::seconds {5}};
+    std::size_t samples {20};
+    bool counters {false};
+    std::string filter;
+    std::string json;
+};
+
+namespace detail
+{
+
+// Cycles, instructions and cache misses of the calling thread, opened as one
+// group so that all three are scheduled on the PMU together. Open() fails
+// quietly where the kernel refuses: perf_event_paranoid above 2, seccomp'ed
+// containers, or VMs without a virtual PMU.
+class PerfCounters
+{
+public:
+    PerfCounters() = default;
+
+    PerfCounters(PerfCounters const&)                    = delete;
+    auto operator=(PerfCounters const&) -> PerfCounters& = delete;
+
+    ~PerfCounters() { close(); }
+
+    auto Open() -> bool
+    {
+#if defined(__linux__)
+        constexpr auto events = std::array<std::uint64_t, 3> {
+            PERF_COUNT_HW_CPU_CYCLES,
+            PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES,
+        };
+
+        for (std::size_t i = 0; i < events.size(); ++i)
+        {
+            auto attr           = perf_event_attr {};
+            attr.size           = sizeof(attr);
+            attr.type           = PERF_TYPE_HARDWARE;
+            attr.config         = events[i];
+            attr.disabled       = i == 0 ? 1 : 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv     = 1;
+            attr.read_format    = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            auto const fd = ::syscall(SYS_perf_event_open, &attr, 0, -1, i == 0 ? -1 : fds_[0], 0);
+            if (fd < 0)
+            {
+                close();
+                return false;
+            }
+            fds_[i] = static_cast<int>(fd);
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    auto Start() -> void
+    {
+#if defined(__linux__)
+        ::ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ::ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+
+    auto Stop() -> BenchmarkCounters
+    {
+#if defined(__linux__)
+        ::ioctl(fds_[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+        // nr, time enabled, time running, one value per event
+        auto buffer = std::array<std::uint64_t, 6> {};
+        if (::read(fds_[0], buffer.data(), sizeof(buffer)) != static_cast<ssize_t>(sizeof(buffer)))
+        {
+            return {};
+        }
+
+        // Scale up if the group was multiplexed with other events.
+        auto const enabled = static_cast<double>(buffer[1]);
+        auto const running = static_cast<double>(buffer[2]);
+        auto const scale   = running > 0 ? enabled / running : 0.0;
+        return {
+            static_cast<double>(buffer[3]) * scale,
+            static_cast<double>(buffer[4]) * scale,
+            static_cast<double>(buffer[5]) * scale,
+        };
+#else
+        return {};
+#endif
+    }
+
+private:
+    auto close() -> void
+    {
+#if defined(__linux__)
+        for (auto& fd : fds_)
+        {
+            if (fd >= 0)
+            {
+                ::close(fd);
+                fd = -1;
+            }
+        }
+#endif
+    }
+
+    std::array<int, 3> fds_ {-1, -1, -1};
+};
+
+// Sorts in place.
+inline auto Median(std::vector<double>& values) -> double
+{
+    std::sort(values.begin(), values.end());
+    auto const mid = values.size() / 2;
+    return values.size() % 2 == 1 ? values[mid] : (values[mid - 1] + values[mid]) / 2.0;
+}
+
+inline auto MedianAbsoluteDeviation(std::vector<double> const& values, double median) -> double
+{
+    auto deviations = std::vector<double>(values.size());
+    std::transform(values.begin(), values.end(), deviations.begin(),
+                   [median](double v) { return std::abs(v - median); });
+    return Median(deviations);
+}
+
+inline auto FormatTime(char* buffer, std::size_t size, double ns) -> char const*
+{
+    if (ns < 1e3)
+    {
+        std::snprintf(buffer, size, "%.2f ns", ns);
+    }
+    else if (ns < 1e6)
+    {
+        std::snprintf(buffer, size, "%.2f us", ns / 1e3);
+    }
+    else if (ns < 1e9)
+    {
+        std::snprintf(buffer, size, "%.2f ms", ns / 1e6);
+    }
+    else
+    {
+        std::snprintf(buffer, size, "%.2f s", ns / 1e9);
+    }
+    return buffer;
+}
+
+inline auto WriteJsonString(std::FILE* out, std::string_view str) -> void
+{
+    std::fputc('"', out);
+    for (auto const c : str)
+    {
+        if (c == '"' || c == '\\')
+        {
+            std::fprintf(out, "\\%c", c);
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            std::fprintf(out, "\\u%04x", static_cast<unsigned>(c));
+        }
+        else
+        {
+            std::fputc(c, out);
+        }
+    }
+    std::fputc('"', out);
+}
+
+}  // namespace detail
+
+/**
+ * @brief Runs benchmarks, prints one line per benchmark and optionally
+ * writes all results as JSON.
+ */
+class Benchmark
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    Benchmark() : Benchmark(BenchmarkOptions {}) { }
+
+    explicit Benchmark(BenchmarkOptions options) : options_ {std::move(options)}
+    {
+        if (options_.counters && !counters_.Open())
+        {
+            std::fprintf(stderr, "benchmark: perf_event_open failed, running without counters\n");
+            options_.counters = false;
+        }
+    }
+
+    /**
+     * @brief Options from the command line. Arguments that do not start
+     * with "--" are left to the caller.
+     */
+    Benchmark(int argc, char const* const* argv) : Benchmark(ParseArguments(argc, argv)) { }
+
+    Benchmark(Benchmark const&)                    = delete;
+    auto operator=(Benchmark const&) -> Benchmark& = delete;
+
+    [[nodiscard]] static auto ParseArguments(int argc, char const* const* argv) -> BenchmarkOptions
+    {
+        auto options = BenchmarkOptions {};
+        for (auto i = 1; i < argc; ++i)
+        {
+            auto const arg   = std::string_view {argv[i]};
+            auto const value = [arg](std::string_view flag) -> std::optional<std::string_view> {
+                if (arg.substr(0, flag.size()) != flag)
+                {
+                    return std::nullopt;
+                }
+                return arg.substr(flag.size());
+            };
+
+            if (arg.substr(0, 2) != "--")
+            {
+                continue;
+            }
+            if (arg == "--counters")
+            {
+                options.counters = true;
+            }
+            else if (auto const filter = value("--filter="))
+            {
+                options.filter = std::string {*filter};
+            }
+            else if (auto const json = value("--json="))
+            {
+                options.json = std::string {*json};
+            }
+            else if (auto const samples = value("--samples="))
+            {
+                options.samples = std::max<std::size_t>(1, std::strtoul(samples->data(), nullptr, 10));
+            }
+            else if (auto const ms = value("--sample-ms="))
+            {
+                options.sampleTime = std::chrono::milliseconds {std::strtoul(ms->data(), nullptr, 10)};
+            }
+            else
+            {
+                std::fprintf(stderr,
+                             "usage: %s [--filter=<substring>] [--json=<file>] [--counters]"
+                             " [--samples=<n>] [--sample-ms=<n>]\n",
+                             argv[0]);
+                std::exit(arg == "--help" ? EXIT_SUCCESS : EXIT_FAILURE);
+            }
+        }
+        return options;
+    }
+
+    /**
+     * @brief Measures body, which is one iteration. Returns nullptr if the
+     * benchmark is excluded by --filter. The result stays valid for the
+     * lifetime of the Benchmark.
+     */
+    template<typename Body>
+    auto Run(std::string_view name, Body&& body) -> BenchmarkResult const*
+    {
+        if (!options_.filter.empty() && name.find(options_.filter) == std::string_view::npos)
+        {
+            return nullptr;
+        }
+
+        auto const batch = [&body](std::uint64_t iterations) {
+            auto const start = Clock::now();
+            for (std::uint64_t i = 0; i < iterations; ++i)
+            {
+                body();
+            }
+            return Clock::now() - start;
+        };
+
+        // Warm up while growing the batch until it fills one sample.
+        auto iterations  = std::uint64_t {1};
+        auto const begin = Clock::now();
+        for (;;)
+        {
+            auto const elapsed = batch(iterations);
+            auto const filled  = elapsed >= options_.sampleTime || iterations >= MaxIterations;
+            if (filled && Clock::now() - begin >= options_.warmup)
+            {
+                break;
+            }
+            if (!filled)
+            {
+                iterations = grow(iterations, elapsed);
+            }
+        }
+
+        auto ns           = std::vector<double> {};
+        auto cycles       = std::vector<double> {};
+        auto instructions = std::vector<double> {};
+        auto cacheMisses  = std::vector<double> {};
+
+        auto const n     = static_cast<double>(iterations);
+        auto const start = Clock::now();
+        while (ns.size() < options_.samples)
+        {
+            if (options_.counters)
+            {
+                counters_.Start();
+            }
+            auto const elapsed = batch(iterations);
+            if (options_.counters)
+            {
+                auto const c = counters_.Stop();
+                cycles.push_back(c.cycles / n);
+                instructions.push_back(c.instructions / n);
+                cacheMisses.push_back(c.cacheMisses / n);
+            }
+            ns.push_back(std::chrono::duration<double, std::nano>(elapsed).count() / n);
+
+            if (ns.size() >= MinSamples && Clock::now() - start >= options_.maxTime)
+            {
+                break;
+            }
+        }
+
+        auto result       = BenchmarkResult {};
+        result.name       = std::string {name};
+        result.iterations = iterations;
+        result.samples    = ns.size();
+        result.min        = *std::min_element(ns.begin(), ns.end());
+        result.median     = detail::Median(ns);
+        result.mad        = detail::MedianAbsoluteDeviation(ns, result.median);
+        if (options_.counters)
+        {
+            result.counters = BenchmarkCounters {
+                detail::Median(cycles),
+                detail::Median(instructions),
+                detail::Median(cacheMisses),
+            };
+        }
+
+        print(result);
+        results_.push_back(std::move(result));
+        return &results_.back();
+    }
+
+    [[nodiscard]] auto Options() const noexcept -> BenchmarkOptions const& { return options_; }
+
+    [[nodiscard]] auto Results() const noexcept -> std::deque<BenchmarkResult> const& { return results_; }
+
+    /**
+     * @brief All results as {"benchmarks": [...]}, times in nanoseconds per
+     * iteration.
+     */
+    auto WriteJson(std::FILE* out) const -> void
+    {
+        std::fprintf(out, "{\n  \"benchmarks\": [");
+        for (std::size_t i = 0; i < results_.size(); ++i)
+        {
+            auto const& r = results_[i];
+            std::fprintf(out, "%s\n    {\"name\": ", i == 0 ? "" : ",");
+            detail::WriteJsonString(out, r.name);
+            std::fprintf(out,
+                         ", \"iterations\": %llu, \"samples\": %zu"
+                         ", \"median_ns\": %.3f, \"mad_ns\": %.3f, \"min_ns\": %.3f",
+                         static_cast<unsigned long long>(r.iterations), r.samples, r.median, r.mad, r.min);
+            if (r.counters)
+            {
+                std::fprintf(out, ", \"cycles\": %.1f, \"instructions\": %.1f, \"cache_misses\": %.3f",
+                             r.counters->cycles, r.counters->instructions, r.counters->cacheMisses);
+            }
+            std::fprintf(out, "}");
+        }
+        std::fprintf(out, "\n  ]\n}\n");
+    }
+
+    /**
+     * @brief Writes the JSON file if one was requested. The return value is
+     * meant to be returned from main.
+     */
+    auto Finish() const -> int
+    {
+        if (options_.json.empty())
+        {
+            return EXIT_SUCCESS;
+        }
+
+        auto* out = std::fopen(options_.json.c_str(), "w");
+        if (out == nullptr)
+        {
+            std::perror(options_.json.c_str());
+            return EXIT_FAILURE;
+        }
+        WriteJson(out);
+        std::fclose(out);
+        return EXIT_SUCCESS;
+    }
+
+private:
+    static constexpr auto MaxIterations = std::uint64_t {1} << 40U;
+    static constexpr auto MinSamples    = std::size_t {5};
+
+    // Aims a little past the sample time so the next batch is likely to be
+    // the last, but grows at most tenfold while the batch is still too short
+    // to time reliably.
+    auto grow(std::uint64_t iterations, Clock::duration elapsed) const -> std::uint64_t
+    {
+        auto const ns     = std::max(std::chrono::duration<double, std::nano>(elapsed).count(), 1.0);
+        auto const target = std::chrono::duration<double, std::nano>(options_.sampleTime).count() * 1.2;
+        auto const next   = static_cast<double>(iterations) * std::min(target / ns, 10.0);
+        return std::clamp(static_cast<std::uint64_t>(next), iterations + 1, MaxIterations);
+    }
+
+    auto print(BenchmarkResult const& r) const -> void
+    {
+        char median[32];
+        char min[32];
+        auto const relative = r.median > 0 ? r.mad / r.median * 100.0 : 0.0;
+        std::printf("%-40s %12s +-%5.1f%%  min %12s  %llu x %zu", r.name.c_str(),
+                    detail::FormatTime(median, sizeof(median), r.median), relative,
+                    detail::FormatTime(min, sizeof(min), r.min), static_cast<unsigned long long>(r.iterations),
+                    r.samples);
+        if (r.counters)
+        {
+            auto const ipc = r.counters->cycles > 0 ? r.counters->instructions / r.counters->cycles : 0.0;
+            std::printf("  %.0f cyc  %.0f ins  %.2f ipc  %.2f miss", r.counters->cycles, r.counters->instructions,
+                        ipc, r.counters->cacheMisses);
+        }
+        std::printf("\n");
+        std::fflush(stdout);
+    }
+
+    BenchmarkOptions options_;
+    detail::PerfCounters counters_;
+    std::deque<BenchmarkResult> results_;
+};
+
+}  // namespace mc
@@ -0,0 +1,23 @@
+#include "suites.hpp"
+
+// usage: cxx_benchmark [--filter=<substring>] [--json=<file>] [--counters]
+//                      [--samples=<n>] [--sample-ms=<n>]
+
+int main(int argc, char** argv)
+{
+    auto bench = mc::Benchmark {argc, argv};
+
+    BenchThreadPool(bench);
+    BenchDft(bench);
+    BenchMatrix(bench);
+
+    // bench_simd.cpp is built for AVX2, this file is not.
+#if defined(MC_BENCH_SIMD)
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    {
+        BenchSimd(bench);
+    }
+#endif
+
+    return bench.Finish();
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "benchmark.hpp"
+
+// One function per benchmarked module, each in its own translation unit so
+// that it can be built with the flags its module needs.
+
+auto BenchThreadPool(mc::Benchmark& bench) -> void;
+auto BenchDft(mc::Benchmark& bench) -> void;
+auto BenchMatrix(mc::Benchmark& bench) -> void;
+auto BenchSimd(mc::Benchmark& bench) -> void;
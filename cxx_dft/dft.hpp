@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+
+#include <complex>
+#include <numbers>
+#include <span>
+
+template<typename T>
+auto discreteFourierTransform(std::span<std::complex<T> const> input,
+                              std::span<std::complex<T>> output) -> void
+{
+    auto const N = input.size();
+    auto const K = N;
+
+    for (std::size_t k = 0; k < K; ++k)
+    {
+        auto tmp = std::complex<T> {};
+        for (std::size_t n = 0; n < N; ++n)
+        {
+            auto const part = ((T {2} * std::numbers::pi_v<T>) / N) * k * n;
+            auto const real = static_cast<T>(std::cos(part));
+            auto const imag = -static_cast<T>(std::sin(part));
+            tmp += input[n] * std::complex<T> {real, imag};
+        }
+        output[k] = tmp;
+    }
+}
@@ -1,5 +1,6 @@
+#include "tbb/info.h"
 #include "tbb/parallel_for.h"
-#include "tbb/task_scheduler_init.h"
+#include "tbb/task_arena.h"
 #include <iostream>
 #include <vector>
 
@@ -19,14 +20,17 @@ struct mytask
 int main(int, char**)
 {
 
-    // tbb::task_scheduler_init init;  // Automatic number of threads
-    tbb::task_scheduler_init init(tbb::task_scheduler_init::default_num_threads());  // Explicit number of threads
+    // task_scheduler_init is gone in oneTBB. An arena with an explicit
+    // number of threads replaces it; without one, TBB sizes itself.
+    tbb::task_arena arena(tbb::info::default_concurrency());
 
     std::vector<mytask> tasks;
     for (int i = 0; i < 1000; ++i) tasks.push_back(mytask(i));
 
-    tbb::parallel_for(tbb::blocked_range<size_t>(0, tasks.size()), [&tasks](const tbb::blocked_range<size_t>& r) {
-        for (size_t i = r.begin(); i < r.end(); ++i) tasks[i]();
+    arena.execute([&tasks] {
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, tasks.size()), [&tasks](const tbb::blocked_range<size_t>& r) {
+            for (size_t i = r.begin(); i < r.end(); ++i) tasks[i]();
+        });
     });
 
     std::cerr << std::endl;
@@ -0,0 +1,101 @@
+#include "tbb/info.h"
+#include "tbb/parallel_pipeline.h"
+#include "tbb/task_arena.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+
+#include <string>
+#include <vector>
+
+// Upper-cases a file (or stdin) to stdout with a three stage pipeline:
+//
+//   read      serial, in order   fills the next block from the input
+//   transform parallel           works on as many blocks as there are tokens
+//   write     serial, in order   writes blocks in the order they were read
+//
+// usage: example_tbb_pipeline [file] [threads]
+
+namespace
+{
+
+constexpr auto BlockSize = std::size_t {64 * 1024};
+
+struct Block
+{
+    std::vector<char> bytes = std::vector<char>(BlockSize);
+    std::size_t size {0};
+};
+
+// One block per token. Blocks enter and leave the pipeline in order, so the
+// ones in flight are consecutive and never share a slot.
+class BlockRing
+{
+public:
+    explicit BlockRing(std::size_t tokens) : blocks_(tokens) { }
+
+    auto Next() -> Block&
+    {
+        auto& block = blocks_[next_];
+        next_       = (next_ + 1) % blocks_.size();
+        return block;
+    }
+
+private:
+    std::vector<Block> blocks_;
+    std::size_t next_ {0};
+};
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    auto* input = argc > 1 ? std::fopen(argv[1], "rb") : stdin;
+    if (input == nullptr)
+    {
+        std::perror(argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    auto const threads = argc > 2 ? std::stoi(argv[2]) : tbb::info::default_concurrency();
+    auto const tokens  = static_cast<std::size_t>(threads) * 4;
+
+    auto ring  = BlockRing {tokens};
+    auto arena = tbb::task_arena {threads};
+
+    auto read = [&ring, input](tbb::flow_control& fc) -> Block* {
+        auto& block = ring.Next();
+        block.size  = std::fread(block.bytes.data(), 1, BlockSize, input);
+        if (block.size == 0)
+        {
+            fc.stop();
+            return nullptr;
+        }
+        return &block;
+    };
+
+    auto transform = [](Block* block) -> Block* {
+        for (std::size_t i = 0; i < block->size; ++i)
+        {
+            auto const c    = static_cast<unsigned char>(block->bytes[i]);
+            block->bytes[i] = static_cast<char>(std::toupper(c));
+        }
+        return block;
+    };
+
+    auto write = [](Block* block) { std::fwrite(block->bytes.data(), 1, block->size, stdout); };
+
+    arena.execute([&] {
+        tbb::parallel_pipeline(tokens, tbb::make_filter<void, Block*>(tbb::filter_mode::serial_in_order, read)
+                                           & tbb::make_filter<Block*, Block*>(tbb::filter_mode::parallel, transform)
+                                           & tbb::make_filter<Block*, void>(tbb::filter_mode::serial_in_order, write));
+    });
+
+    if (input != stdin)
+    {
+        std::fclose(input);
+    }
+
+    return EXIT_SUCCESS;
+}
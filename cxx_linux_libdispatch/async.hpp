@@ -1,26 +1,25 @@
 #pragma once
 
+#include "dispatch.hpp"
+
+#if defined(MC_USE_LIBDISPATCH)
 #include <dispatch/dispatch.h>
+#endif
 
 #include <cassert>
+#include <cstddef>
 
+#include <algorithm>
+#include <exception>
 #include <functional>
 #include <future>
+#include <thread>
 #include <type_traits>
 
 namespace mc
 {
 
-/**
- * @brief Tag enum for selecting the async queue priority when dispatching tasks with mc::Async.
- */
-enum class QueuePriority
-{
-    Default,
-    Low,
-    High,
-    Message,
-};
+#if defined(MC_USE_LIBDISPATCH)
 
 namespace detail
 {
@@ -28,7 +27,7 @@ namespace detail
 template<typename Function, typename... Args>
 auto AsyncImpl(dispatch_queue_t queue, Function&& f, Args&&... args)
 {
-    using result_type   = std::result_of_t<std::decay_t<Function>(std::decay_t<Args>...)>;
+    using result_type   = std::invoke_result_t<std::decay_t<Function>, std::decay_t<Args>...>;
     using packaged_type = std::packaged_task<result_type()>;
 
     auto func    = [_f = std::forward<Function>(f)](Args&... args) { return _f(std::move(args)...); };
@@ -45,7 +44,7 @@ auto AsyncImpl(dispatch_queue_t queue, Function&& f, Args&&... args)
     return result;
 }
 
-auto SelectDispatchQueue(QueuePriority queueType) -> dispatch_queue_t
+inline auto SelectDispatchQueue(QueuePriority queueType) -> dispatch_queue_t
 {
     switch (queueType)
     {
@@ -72,6 +71,9 @@ auto SelectDispatchQueue(QueuePriority queueType) -> dispatch_queue_t
 
 }  // namespace detail
 
+namespace libdispatch
+{
+
 template<typename Function, typename... Args>
 auto Async(QueuePriority queueType, Function&& f, Args&&... args)
 {
@@ -80,4 +82,86 @@ auto Async(QueuePriority queueType, Function&& f, Args&&... args)
     return detail::AsyncImpl(queue, std::forward<Function>(f), std::forward<Args>(args)...);
 }
 
-}  // namespace mc
\ No newline at end of file
+// dispatch_apply_f with one iteration per participant; each claims strides
+// from the shared state, see portable::Apply.
+template<typename Function>
+auto Apply(QueuePriority queueType, std::size_t n, Function&& f) -> void
+{
+    if (n == 0)
+    {
+        return;
+    }
+
+    auto const workers = std::max(1U, std::thread::hardware_concurrency());
+    auto const stride  = detail::ApplyStride(n, workers);
+    auto state         = detail::ApplyState<std::remove_reference_t<Function>> {n, stride, f};
+
+    // dispatch_apply on the main queue from the main thread deadlocks.
+    if (queueType == QueuePriority::Message)
+    {
+        state.Work();
+        if (auto error = state.Error())
+        {
+            std::rethrow_exception(error);
+        }
+        return;
+    }
+
+    auto queue = detail::SelectDispatchQueue(queueType);
+    assert(queue);
+    dispatch_apply_f(std::min<std::size_t>(workers, (n + stride - 1) / stride), queue, &state,
+                     +[](void* userData, std::size_t /*iteration*/) {
+                         static_cast<decltype(state)*>(userData)->Work();
+                     });
+    if (auto error = state.Error())
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+}  // namespace libdispatch
+
+namespace backend = libdispatch;
+
+#else
+
+namespace backend = portable;
+
+#endif
+
+/**
+ * @brief Runs f(args...) on the global queue of the given priority and
+ * returns a std::future for the result.
+ *
+ * Built with -DMC_USE_LIBDISPATCH this goes through libdispatch, otherwise
+ * through the pure C++ queues in dispatch.hpp. Both are available side by
+ * side as mc::libdispatch::Async and mc::portable::Async.
+ */
+template<typename Function, typename... Args>
+auto Async(QueuePriority queueType, Function&& f, Args&&... args)
+{
+    return backend::Async(queueType, std::forward<Function>(f), std::forward<Args>(args)...);
+}
+
+/**
+ * @brief Calls f(i) for every i in [0, n) on the queue of the given priority
+ * and returns once all are done, rethrowing the first exception. Iterations
+ * are grouped into strides automatically, see portable::Apply.
+ */
+template<typename Function>
+auto Apply(QueuePriority queueType, std::size_t n, Function&& f) -> void
+{
+    backend::Apply(queueType, n, std::forward<Function>(f));
+}
+
+/**
+ * @brief Runs f(args...) on the given queue as part of group. Always uses the
+ * pure C++ backend, see portable::Async.
+ */
+template<typename Function, typename... Args>
+auto Async(DispatchGroup& group, QueuePriority queueType, Function&& f, Args&&... args) -> void
+{
+    portable::Async(group, queueType, std::forward<Function>(f), std::forward<Args>(args)...);
+}
+
+}  // namespace mc
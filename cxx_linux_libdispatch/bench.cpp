@@ -0,0 +1,195 @@
+#include "async.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+auto NanosPer(Clock::duration d, int n) -> double
+{
+    return std::chrono::duration<double, std::nano>(d).count() / static_cast<double>(n);
+}
+
+// Submit n trivial tasks, then wait for every future.
+template<typename AsyncFunc>
+auto Futures(char const* name, int n, AsyncFunc async) -> void
+{
+    auto futures = std::vector<std::future<int>> {};
+    futures.reserve(static_cast<std::size_t>(n));
+
+    auto const start = Clock::now();
+    for (auto i = 0; i < n; ++i)
+    {
+        futures.push_back(async([](int x) { return x + 1; }, i));
+    }
+    auto sum = 0L;
+    for (auto& f : futures)
+    {
+        sum += f.get();
+    }
+    auto const elapsed = Clock::now() - start;
+
+    std::printf("%-30s %8.1f ns/task  (checksum %ld)\n", name, NanosPer(elapsed, n), sum);
+}
+
+auto PortableGroup(int n) -> void
+{
+    auto counter = std::atomic<long> {0};
+    auto group   = mc::DispatchGroup {};
+
+    auto const start = Clock::now();
+    for (auto i = 0; i < n; ++i)
+    {
+        mc::portable::Async(group, mc::QueuePriority::Default,
+                            [&counter](int x) { counter.fetch_add(x, std::memory_order_relaxed); }, 1);
+    }
+    group.Wait();
+    auto const elapsed = Clock::now() - start;
+
+    std::printf("%-30s %8.1f ns/task  (checksum %ld)\n", "portable group", NanosPer(elapsed, n), counter.load());
+}
+
+auto PortableSerial(int n) -> void
+{
+    auto queue    = mc::SerialQueue {};
+    auto last     = -1;
+    auto inOrder  = true;
+    auto futures  = std::vector<std::future<void>> {};
+    futures.reserve(static_cast<std::size_t>(n));
+
+    auto const start = Clock::now();
+    for (auto i = 0; i < n; ++i)
+    {
+        // No synchronization needed, the queue runs one job at a time.
+        futures.push_back(queue.Async([&last, &inOrder, i] {
+            inOrder = inOrder && last + 1 == i;
+            last    = i;
+        }));
+    }
+    for (auto& f : futures)
+    {
+        f.get();
+    }
+    auto const elapsed = Clock::now() - start;
+
+    std::printf("%-30s %8.1f ns/task  (%s)\n", "portable serial queue", NanosPer(elapsed, n),
+                inOrder ? "in order" : "OUT OF ORDER");
+}
+
+// The same fan-out as one future per index and as one Apply call.
+auto FanOut(int n) -> void
+{
+    auto out  = std::vector<double>(static_cast<std::size_t>(n));
+    auto fill = [&out](std::size_t i) { out[i] = static_cast<double>(i) * 0.5; };
+
+    auto const asyncStart = Clock::now();
+    auto futures          = std::vector<std::future<void>> {};
+    futures.reserve(out.size());
+    for (std::size_t i = 0; i < out.size(); ++i)
+    {
+        futures.push_back(mc::Async(mc::QueuePriority::Default, fill, i));
+    }
+    for (auto& f : futures)
+    {
+        f.get();
+    }
+    auto const asyncElapsed = Clock::now() - asyncStart;
+
+    auto const applyStart = Clock::now();
+    mc::Apply(mc::QueuePriority::Default, out.size(), fill);
+    auto const applyElapsed = Clock::now() - applyStart;
+
+    std::printf("%-30s %8.1f ns/index\n", "fan-out, Async per index", NanosPer(asyncElapsed, n));
+    std::printf("%-30s %8.1f ns/index\n", "fan-out, one Apply", NanosPer(applyElapsed, n));
+}
+
+// Apply from inside tasks on the pool, more of them than there are
+// workers, so every worker is inside an Apply whose helpers have nowhere to
+// run. Only completes if the callers do not wait for their helpers.
+auto NestedApply(int n) -> void
+{
+    auto const tasks = 2 * std::max(1U, std::thread::hardware_concurrency());
+    auto total       = std::atomic<long> {0};
+
+    auto const start = Clock::now();
+    auto futures     = std::vector<std::future<void>> {};
+    for (auto t = 0U; t < tasks; ++t)
+    {
+        futures.push_back(mc::Async(mc::QueuePriority::Default, [n, &total] {
+            mc::Apply(mc::QueuePriority::Default, static_cast<std::size_t>(n),
+                      [&total](std::size_t) { total.fetch_add(1, std::memory_order_relaxed); });
+        }));
+    }
+    for (auto& f : futures)
+    {
+        f.get();
+    }
+    auto const elapsed = Clock::now() - start;
+
+    auto const expected = static_cast<long>(tasks) * n;
+    std::printf("%-30s %8.1f ns/index  (%s)\n", "nested Apply", NanosPer(elapsed, static_cast<int>(expected)),
+                total.load() == expected ? "complete" : "INCOMPLETE");
+}
+
+#if defined(MC_USE_LIBDISPATCH)
+auto LibdispatchGroup(int n) -> void
+{
+    auto counter = std::atomic<long> {0};
+    auto group   = dispatch_group_create();
+    auto queue   = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+
+    auto const start = Clock::now();
+    for (auto i = 0; i < n; ++i)
+    {
+        dispatch_group_async_f(group, queue, &counter, +[](void* userData) {
+            static_cast<std::atomic<long>*>(userData)->fetch_add(1, std::memory_order_relaxed);
+        });
+    }
+    dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+    auto const elapsed = Clock::now() - start;
+    dispatch_release(group);
+
+    std::printf("%-30s %8.1f ns/task  (checksum %ld)\n", "libdispatch group", NanosPer(elapsed, n), counter.load());
+}
+#endif
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    auto const n = argc > 1 ? std::stoi(argv[1]) : 1'000'000;
+
+    Futures("portable Async", n, [](auto&&... args) {
+        return mc::portable::Async(mc::QueuePriority::Default, std::forward<decltype(args)>(args)...);
+    });
+#if defined(MC_USE_LIBDISPATCH)
+    Futures("libdispatch Async", n, [](auto&&... args) {
+        return mc::libdispatch::Async(mc::QueuePriority::Default, std::forward<decltype(args)>(args)...);
+    });
+#endif
+
+    PortableGroup(n);
+#if defined(MC_USE_LIBDISPATCH)
+    LibdispatchGroup(n);
+#endif
+
+    PortableSerial(n);
+
+    FanOut(128);
+    FanOut(n);
+
+    NestedApply(100'000);
+
+    return EXIT_SUCCESS;
+}
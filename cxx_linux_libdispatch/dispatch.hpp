@@ -0,0 +1,805 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace mc
+{
+
+/**
+ * @brief Tag enum for selecting the async queue priority when dispatching tasks with mc::Async.
+ */
+enum class QueuePriority
+{
+    Default,
+    Low,
+    High,
+    Message,
+};
+
+namespace detail
+{
+
+/**
+ * @brief Intrusive unit of work. Whoever runs it also frees it.
+ */
+struct Job
+{
+    Job* next {nullptr};
+    void (*run)(Job*) {nullptr};
+};
+
+/**
+ * @brief Singly linked FIFO of jobs, not synchronized.
+ */
+class JobList
+{
+public:
+    [[nodiscard]] auto empty() const noexcept -> bool { return head_ == nullptr; }
+
+    auto push(Job* job) noexcept -> void
+    {
+        job->next = nullptr;
+        if (tail_ == nullptr)
+        {
+            head_ = job;
+        }
+        else
+        {
+            tail_->next = job;
+        }
+        tail_ = job;
+    }
+
+    auto pop() noexcept -> Job*
+    {
+        auto* job = head_;
+        if (job != nullptr)
+        {
+            head_ = job->next;
+            if (head_ == nullptr)
+            {
+                tail_ = nullptr;
+            }
+        }
+        return job;
+    }
+
+private:
+    Job* head_ {nullptr};
+    Job* tail_ {nullptr};
+};
+
+/**
+ * @brief The callable and its arguments, invoked the way std::async would.
+ */
+template<typename Function, typename... Args>
+struct Invocation
+{
+    using result_type = std::invoke_result_t<std::decay_t<Function>, std::decay_t<Args>...>;
+
+    template<typename F, typename... A>
+    explicit Invocation(F&& f, A&&... args) : func {std::forward<F>(f)}, arguments {std::forward<A>(args)...}
+    {
+    }
+
+    auto operator()() -> result_type { return std::apply(std::move(func), std::move(arguments)); }
+
+    std::decay_t<Function> func;
+    std::tuple<std::decay_t<Args>...> arguments;
+};
+
+/**
+ * @brief A job that fulfills a std::promise. One allocation for the job,
+ * callable and arguments, plus the promise's shared state.
+ */
+template<typename Function, typename... Args>
+struct FutureJob : Job
+{
+    using invocation  = Invocation<Function, Args...>;
+    using result_type = typename invocation::result_type;
+
+    template<typename... A>
+    explicit FutureJob(A&&... args) : Job {nullptr, &FutureJob::Run}, call {std::forward<A>(args)...}
+    {
+    }
+
+    static auto Run(Job* job) -> void
+    {
+        auto* self = static_cast<FutureJob*>(job);
+        try
+        {
+            if constexpr (std::is_void_v<result_type>)
+            {
+                self->call();
+                self->promise.set_value();
+            }
+            else
+            {
+                self->promise.set_value(self->call());
+            }
+        }
+        catch (...)
+        {
+            self->promise.set_exception(std::current_exception());
+        }
+        delete self;
+    }
+
+    invocation call;
+    std::promise<result_type> promise;
+};
+
+/**
+ * @brief A job without a result, for fire and forget submissions.
+ */
+template<typename Function>
+struct FunctionJob : Job
+{
+    template<typename F>
+    explicit FunctionJob(F&& f) : Job {nullptr, &FunctionJob::Run}, func {std::forward<F>(f)}
+    {
+    }
+
+    static auto Run(Job* job) -> void
+    {
+        auto* self = static_cast<FunctionJob*>(job);
+        self->func();
+        delete self;
+    }
+
+    Function func;
+};
+
+template<typename Function>
+auto MakeFunctionJob(Function&& f) -> Job*
+{
+    return new FunctionJob<std::decay_t<Function>>(std::forward<Function>(f));
+}
+
+/**
+ * @brief The global concurrent queues: one worker per core, shared by the
+ * High, Default and Low lanes. Workers always take from the highest
+ * priority lane that has work, in FIFO order within a lane.
+ */
+class WorkerPool
+{
+public:
+    static constexpr std::size_t LaneCount = 3;
+
+    explicit WorkerPool(std::size_t threads = std::max(1U, std::thread::hardware_concurrency()))
+    {
+        workers_.reserve(threads);
+        for (std::size_t i = 0; i < threads; ++i)
+        {
+            workers_.emplace_back([this] { work(); });
+        }
+    }
+
+    WorkerPool(WorkerPool const&)                    = delete;
+    auto operator=(WorkerPool const&) -> WorkerPool& = delete;
+
+    ~WorkerPool()
+    {
+        {
+            auto lock = std::scoped_lock {mutex_};
+            stop_     = true;
+        }
+        wakeup_.notify_all();
+        for (auto& worker : workers_)
+        {
+            worker.join();
+        }
+    }
+
+    [[nodiscard]] static auto GlobalInstance() -> WorkerPool&
+    {
+        static auto pool = WorkerPool {};
+        return pool;
+    }
+
+    [[nodiscard]] auto Size() const noexcept -> std::size_t { return workers_.size(); }
+
+    auto Submit(QueuePriority priority, Job* job) -> void
+    {
+        auto notify = false;
+        {
+            auto lock = std::scoped_lock {mutex_};
+            lanes_[lane(priority)].push(job);
+            notify = sleeping_ != 0;
+        }
+        if (notify)
+        {
+            wakeup_.notify_one();
+        }
+    }
+
+private:
+    static constexpr auto lane(QueuePriority priority) noexcept -> std::size_t
+    {
+        switch (priority)
+        {
+            case QueuePriority::High: return 0;
+            case QueuePriority::Low: return 2;
+            default: return 1;
+        }
+    }
+
+    auto work() -> void
+    {
+        auto lock = std::unique_lock {mutex_};
+        while (true)
+        {
+            auto* job = pop();
+            if (job == nullptr)
+            {
+                if (stop_)
+                {
+                    return;
+                }
+                ++sleeping_;
+                wakeup_.wait(lock);
+                --sleeping_;
+                continue;
+            }
+
+            lock.unlock();
+            job->run(job);
+            lock.lock();
+        }
+    }
+
+    auto pop() noexcept -> Job*
+    {
+        for (auto& l : lanes_)
+        {
+            if (auto* job = l.pop(); job != nullptr)
+            {
+                return job;
+            }
+        }
+        return nullptr;
+    }
+
+    std::mutex mutex_;
+    std::condition_variable wakeup_;
+    std::array<JobList, LaneCount> lanes_ {};
+    std::size_t sleeping_ {0};
+    bool stop_ {false};
+    std::vector<std::thread> workers_;
+};
+
+/**
+ * @brief Jobs for QueuePriority::Message. Like the libdispatch main queue
+ * they only run when the owning thread drains them.
+ */
+class MainQueue
+{
+public:
+    [[nodiscard]] static auto GlobalInstance() -> MainQueue&
+    {
+        static auto queue = MainQueue {};
+        return queue;
+    }
+
+    auto Submit(Job* job) -> void
+    {
+        auto lock = std::scoped_lock {mutex_};
+        jobs_.push(job);
+    }
+
+    auto Drain() -> std::size_t
+    {
+        auto count = std::size_t {0};
+        while (true)
+        {
+            auto* job = [this] {
+                auto lock = std::scoped_lock {mutex_};
+                return jobs_.pop();
+            }();
+            if (job == nullptr)
+            {
+                return count;
+            }
+            job->run(job);
+            ++count;
+        }
+    }
+
+private:
+    std::mutex mutex_;
+    JobList jobs_;
+};
+
+inline auto Submit(QueuePriority priority, Job* job) -> void
+{
+    if (priority == QueuePriority::Message)
+    {
+        MainQueue::GlobalInstance().Submit(job);
+    }
+    else
+    {
+        WorkerPool::GlobalInstance().Submit(priority, job);
+    }
+}
+
+// Iterations per claim for Apply: about eight claims per worker, so uneven
+// iterations even out without every index paying for an atomic.
+inline auto ApplyStride(std::size_t n, std::size_t workers) noexcept -> std::size_t
+{
+    return std::max<std::size_t>(1, n / (std::max<std::size_t>(1, workers) * 8));
+}
+
+/**
+ * @brief Shared state of one Apply call. Every participant claims strides
+ * of indices from the same counter until none are left, so it does not
+ * matter how many of them actually get to run, or when. Completion is
+ * counted per stride, not per participant: the caller waits for the last
+ * stride to finish, and a participant that starts after that finds nothing
+ * left to claim and never calls the function.
+ */
+template<typename Function>
+class ApplyState
+{
+public:
+    ApplyState(std::size_t n, std::size_t stride, Function& f)
+        : n_ {n}, stride_ {stride}, strides_ {(n + stride - 1) / stride}, func_ {f}
+    {
+    }
+
+    [[nodiscard]] auto Strides() const noexcept -> std::size_t { return strides_; }
+
+    auto Work() noexcept -> void
+    {
+        while (true)
+        {
+            auto const begin = next_.fetch_add(stride_, std::memory_order_relaxed);
+            if (begin >= n_)
+            {
+                return;
+            }
+
+            // After a failure the remaining strides are claimed and counted,
+            // but not run.
+            if (!failed_.load(std::memory_order_relaxed))
+            {
+                run(begin, std::min(n_, begin + stride_));
+            }
+
+            if (finished_.fetch_add(1, std::memory_order_acq_rel) + 1 == strides_)
+            {
+                auto lock = std::scoped_lock {mutex_};
+                done_.notify_all();
+            }
+        }
+    }
+
+    // Blocks until every stride is finished. The caller must have run Work
+    // itself, so this returns even if no other participant ever starts.
+    auto Wait() -> void
+    {
+        auto lock = std::unique_lock {mutex_};
+        done_.wait(lock, [this] { return finished_.load(std::memory_order_acquire) == strides_; });
+    }
+
+    // Only after Wait, or once every participant has returned from Work.
+    [[nodiscard]] auto Error() const noexcept -> std::exception_ptr { return error_; }
+
+private:
+    auto run(std::size_t begin, std::size_t end) noexcept -> void
+    {
+        try
+        {
+            for (auto i = begin; i != end; ++i)
+            {
+                std::invoke(func_, i);
+            }
+        }
+        catch (...)
+        {
+            if (!failed_.exchange(true, std::memory_order_relaxed))
+            {
+                error_ = std::current_exception();
+            }
+        }
+    }
+
+    std::size_t n_;
+    std::size_t stride_;
+    std::size_t strides_;
+    Function& func_;
+    std::atomic<std::size_t> next_ {0};
+    std::atomic<std::size_t> finished_ {0};
+    std::atomic<bool> failed_ {false};
+    std::exception_ptr error_;
+    std::mutex mutex_;
+    std::condition_variable done_;
+};
+
+}  // namespace detail
+
+namespace portable
+{
+
+/**
+ * @brief Runs f(args...) on the global queue of the given priority.
+ *
+ * Same contract as the libdispatch backend: returns a std::future for the
+ * result, arguments are decay-copied, exceptions end up in the future.
+ */
+template<typename Function, typename... Args>
+auto Async(QueuePriority priority, Function&& f, Args&&... args)
+{
+    using job_type = detail::FutureJob<Function, Args...>;
+
+    auto* job   = new job_type(std::forward<Function>(f), std::forward<Args>(args)...);
+    auto result = job->promise.get_future();
+    detail::Submit(priority, job);
+    return result;
+}
+
+/**
+ * @brief Runs everything submitted with QueuePriority::Message so far, on
+ * the calling thread. Returns the number of jobs run.
+ */
+inline auto DrainMainQueue() -> std::size_t { return detail::MainQueue::GlobalInstance().Drain(); }
+
+/**
+ * @brief Calls f(i) for every i in [0, n) on the queue of the given priority
+ * and returns when all calls are done, like dispatch_apply.
+ *
+ * Indices are handed out in strides and the calling thread takes part. The
+ * state and the helper jobs for the workers share a single allocation, freed
+ * by whichever participant leaves last, and none is made if no helper is
+ * needed. The caller only waits for claimed strides to finish, never for a
+ * helper to start, so Apply may be nested in Apply or Async. The first
+ * exception thrown by f stops further strides and is rethrown here. With
+ * QueuePriority::Message everything runs on the calling thread.
+ */
+template<typename Function>
+auto Apply(QueuePriority priority, std::size_t n, Function&& f) -> void
+{
+    if (n == 0)
+    {
+        return;
+    }
+
+    using state_type = detail::ApplyState<std::remove_reference_t<Function>>;
+
+    auto& pool         = detail::WorkerPool::GlobalInstance();
+    auto const stride  = detail::ApplyStride(n, pool.Size());
+    auto const strides = (n + stride - 1) / stride;
+    auto const helpers = priority == QueuePriority::Message ? 0 : std::min(pool.Size(), strides) - 1;
+    if (helpers == 0)
+    {
+        auto state = state_type {n, stride, f};
+        state.Work();
+        if (auto error = state.Error())
+        {
+            std::rethrow_exception(error);
+        }
+        return;
+    }
+
+    // Helpers may start after Apply has returned, e.g. when Apply runs on a
+    // worker and every other worker is busy, so the state they touch is
+    // shared with them and freed by whoever leaves last.
+    struct Shared;
+
+    struct Helper : detail::Job
+    {
+        Helper() : Job {nullptr, &Helper::Run} {}
+
+        static auto Run(detail::Job* job) -> void
+        {
+            auto* shared = static_cast<Helper*>(job)->shared;
+            shared->state.Work();
+            Shared::Release(shared);
+        }
+
+        Shared* shared {nullptr};
+    };
+
+    // One block: the shared state, then the helper jobs.
+    struct Shared
+    {
+        Shared(std::size_t count, std::size_t n, std::size_t stride, std::remove_reference_t<Function>& f)
+            : state {n, stride, f}, jobs {count}, refs {count + 1}
+        {
+        }
+
+        static auto Create(std::size_t count, std::size_t n, std::size_t stride,
+                           std::remove_reference_t<Function>& f) -> Shared*
+        {
+            auto* memory = ::operator new(offset() + count * sizeof(Helper), alignment());
+            auto* shared = static_cast<Shared*>(nullptr);
+            try
+            {
+                shared = ::new (memory) Shared {count, n, stride, f};
+            }
+            catch (...)
+            {
+                ::operator delete(memory, alignment());
+                throw;
+            }
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                ::new (static_cast<void*>(shared->job(i))) Helper {};
+                shared->job(i)->shared = shared;
+            }
+            return shared;
+        }
+
+        static auto Release(Shared* shared) -> void
+        {
+            if (shared->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                for (std::size_t i = 0; i < shared->jobs; ++i)
+                {
+                    shared->job(i)->~Helper();
+                }
+                shared->~Shared();
+                ::operator delete(static_cast<void*>(shared), alignment());
+            }
+        }
+
+        static constexpr auto alignment() noexcept -> std::align_val_t
+        {
+            return std::align_val_t {std::max(alignof(Shared), alignof(Helper))};
+        }
+
+        static constexpr auto offset() noexcept -> std::size_t
+        {
+            return (sizeof(Shared) + alignof(Helper) - 1) / alignof(Helper) * alignof(Helper);
+        }
+
+        auto job(std::size_t i) noexcept -> Helper*
+        {
+            auto* address = reinterpret_cast<std::byte*>(this) + offset() + i * sizeof(Helper);
+            return std::launder(reinterpret_cast<Helper*>(address));
+        }
+
+        state_type state;
+        std::size_t jobs;
+        std::atomic<std::size_t> refs;
+    };
+
+    auto* shared = Shared::Create(helpers, n, stride, f);
+    for (std::size_t i = 0; i < helpers; ++i)
+    {
+        pool.Submit(priority, shared->job(i));
+    }
+
+    // The caller claims strides too, so this finishes even if none of the
+    // helpers get a worker until much later.
+    shared->state.Work();
+    shared->state.Wait();
+
+    auto error = shared->state.Error();
+    Shared::Release(shared);
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+}  // namespace portable
+
+/**
+ * @brief Tracks a set of submissions, like dispatch_group_t.
+ *
+ * Async(group, ...) counts work in, its completion counts it out. Wait
+ * blocks until the count is zero, Notify schedules a job for that moment.
+ * The group must outlive the work submitted to it.
+ */
+class DispatchGroup
+{
+public:
+    DispatchGroup() = default;
+
+    DispatchGroup(DispatchGroup const&)                    = delete;
+    auto operator=(DispatchGroup const&) -> DispatchGroup& = delete;
+
+    ~DispatchGroup() { Wait(); }
+
+    auto Enter() -> void
+    {
+        auto lock = std::scoped_lock {mutex_};
+        ++pending_;
+    }
+
+    auto Leave() -> void
+    {
+        auto notify = std::vector<std::pair<QueuePriority, detail::Job*>> {};
+        {
+            auto lock = std::scoped_lock {mutex_};
+            if (--pending_ != 0)
+            {
+                return;
+            }
+            notify.swap(notify_);
+            done_.notify_all();
+        }
+
+        for (auto [priority, job] : notify)
+        {
+            detail::Submit(priority, job);
+        }
+    }
+
+    auto Wait() -> void
+    {
+        auto lock = std::unique_lock {mutex_};
+        done_.wait(lock, [this] { return pending_ == 0; });
+    }
+
+    // False if work is still pending when the time is up.
+    template<class Rep, class Period>
+    auto WaitFor(std::chrono::duration<Rep, Period> const& timeout) -> bool
+    {
+        auto lock = std::unique_lock {mutex_};
+        return done_.wait_for(lock, timeout, [this] { return pending_ == 0; });
+    }
+
+    // Submits f to the queue once all work entered so far has left.
+    template<typename Function>
+    auto Notify(QueuePriority priority, Function&& f) -> void
+    {
+        auto* job = detail::MakeFunctionJob(std::forward<Function>(f));
+        {
+            auto lock = std::scoped_lock {mutex_};
+            if (pending_ != 0)
+            {
+                notify_.emplace_back(priority, job);
+                return;
+            }
+        }
+        detail::Submit(priority, job);
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable done_;
+    std::size_t pending_ {0};
+    std::vector<std::pair<QueuePriority, detail::Job*>> notify_;
+};
+
+namespace portable
+{
+
+/**
+ * @brief Fire and forget f(args...) as part of group, like dispatch_group_async.
+ *
+ * One allocation per call, there is no future to fulfill. As with a block,
+ * there is nobody to report an exception to, so f should not throw; if it
+ * does the exception is dropped and the group still counts the work as done.
+ */
+template<typename Function, typename... Args>
+auto Async(DispatchGroup& group, QueuePriority priority, Function&& f, Args&&... args) -> void
+{
+    group.Enter();
+    detail::Submit(priority,
+                   detail::MakeFunctionJob([&group, call = detail::Invocation<Function, Args...>(
+                                                        std::forward<Function>(f), std::forward<Args>(args)...)]() mutable {
+                       try
+                       {
+                           call();
+                       }
+                       catch (...)
+                       {
+                       }
+                       group.Leave();
+                   }));
+}
+
+}  // namespace portable
+
+/**
+ * @brief Runs its jobs one at a time, in submission order, on the workers of
+ * the global queue it targets, like a serial dispatch_queue_t.
+ *
+ * Nothing is bound to a thread: while the queue has work, one drain job sits
+ * on the target queue and runs a batch of items before yielding the worker.
+ * The destructor waits for queued work to finish.
+ */
+class SerialQueue
+{
+public:
+    static constexpr std::size_t BatchSize = 16;
+
+    explicit SerialQueue(QueuePriority target = QueuePriority::Default) : drain_ {this}, target_ {target} {}
+
+    SerialQueue(SerialQueue const&)                    = delete;
+    auto operator=(SerialQueue const&) -> SerialQueue& = delete;
+
+    ~SerialQueue()
+    {
+        auto lock = std::unique_lock {mutex_};
+        idle_.wait(lock, [this] { return !scheduled_; });
+    }
+
+    template<typename Function, typename... Args>
+    auto Async(Function&& f, Args&&... args)
+    {
+        using job_type = detail::FutureJob<Function, Args...>;
+
+        auto* job   = new job_type(std::forward<Function>(f), std::forward<Args>(args)...);
+        auto result = job->promise.get_future();
+        push(job);
+        return result;
+    }
+
+private:
+    struct DrainJob : detail::Job
+    {
+        explicit DrainJob(SerialQueue* queue) : Job {nullptr, &SerialQueue::Drain}, self {queue} {}
+
+        SerialQueue* self;
+    };
+
+    static auto Drain(detail::Job* job) -> void
+    {
+        auto& self = *static_cast<DrainJob*>(job)->self;
+        for (std::size_t i = 0; i < BatchSize; ++i)
+        {
+            auto* next = [&self] {
+                auto lock = std::scoped_lock {self.mutex_};
+                auto* j   = self.jobs_.pop();
+                if (j == nullptr)
+                {
+                    self.scheduled_ = false;
+                    self.idle_.notify_all();
+                }
+                return j;
+            }();
+
+            if (next == nullptr)
+            {
+                return;
+            }
+            next->run(next);
+        }
+
+        // More work left: go to the back of the target queue so other queues
+        // get a turn.
+        detail::Submit(self.target_, &self.drain_);
+    }
+
+    auto push(detail::Job* job) -> void
+    {
+        auto schedule = false;
+        {
+            auto lock = std::scoped_lock {mutex_};
+            jobs_.push(job);
+            schedule   = !scheduled_;
+            scheduled_ = true;
+        }
+        if (schedule)
+        {
+            detail::Submit(target_, &drain_);
+        }
+    }
+
+    DrainJob drain_;
+    QueuePriority target_;
+    std::mutex mutex_;
+    std::condition_variable idle_;
+    detail::JobList jobs_;
+    bool scheduled_ {false};
+};
+
+}  // namespace mc
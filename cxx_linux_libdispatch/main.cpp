@@ -1,5 +1,6 @@
 #include "async.hpp"
 
+#include <cstddef>
 #include <cstdio>
 #include <cstdlib>
 
@@ -11,18 +12,13 @@
 
 int main()
 {
-    std::vector<std::future<std::vector<char>>> tasks;
-    tasks.reserve(128);
-    std::generate_n(std::back_inserter(tasks), 128, [] {
-        return mc::Async(mc::QueuePriority::Default, [] {
-            auto input = std::ifstream("/home/tobante/bin/bin/_pcbnew.kiface", std::ios::binary);
-            auto bytes = std::vector<char>((std::istreambuf_iterator<char>(input)), (std::istreambuf_iterator<char>()));
-            input.close();
-            return bytes;
-        });
+    auto files = std::vector<std::vector<char>>(128);
+    mc::Apply(mc::QueuePriority::Default, files.size(), [&files](std::size_t i) {
+        auto input = std::ifstream("/home/tobante/bin/bin/_pcbnew.kiface", std::ios::binary);
+        files[i]   = std::vector<char>((std::istreambuf_iterator<char>(input)), (std::istreambuf_iterator<char>()));
     });
 
-    std::for_each(begin(tasks), end(tasks), [](auto& f) { std::cout << f.get().size() << '\n'; });
+    std::for_each(begin(files), end(files), [](auto const& bytes) { std::cout << bytes.size() << '\n'; });
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,161 @@
+#include <mc/mna/mna_system.hpp>
+#include <mc/spice/compact_circuit.hpp>
+#include <mc/spice/spice_circuit.hpp>
+#include <mc/spice/spice_netlist.hpp>
+
+#include <benchmark.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <thread>
+
+// loadSpiceCircuit against loadSpiceNetlist, serial and parallel, on a
+// generated netlist: a resistor grid with a capacitor from every node to
+// ground, a source in one corner, and the usual mix of suffixes, comments
+// and blank lines. Then assembleDcSystem on the SpiceCircuit against the
+// CompactCircuit of the same netlist.
+
+namespace {
+
+auto generateNetlist(std::filesystem::path const& path, int elements) -> void
+{
+    static constexpr char const* ohms[]   = {"1k", "4.7K", "220", "1.5MEG", "10", "2.2e3"};
+    static constexpr char const* farads[] = {"10u", "100p", "1n", "4.7N", "0.1U"};
+
+    auto const side = static_cast<int>(std::sqrt(elements / 3.0)) + 1;
+    auto text       = std::string{"generated grid\n* resistors and capacitors\n"};
+    auto out        = std::back_inserter(text);
+    fmt::format_to(out, "V1 n0_0 0 5\n");
+
+    auto count = 1;
+    for (auto row = 0; row < side && count < elements; ++row) {
+        fmt::format_to(out, "\n* row {}\n", row);
+        for (auto col = 0; col < side && count < elements; ++col, count += 3) {
+            fmt::format_to(out, "R{} n{}_{} n{}_{} {}\n", count, row, col, row, col + 1,
+                           ohms[count % 6]);
+            fmt::format_to(out, "R{} n{}_{} n{}_{} {}\n", count + 1, row, col, row + 1, col,
+                           ohms[(count + 1) % 6]);
+            fmt::format_to(out, "C{} n{}_{} 0 {}\n", count + 2, row, col,
+                           farads[count % 5]);
+        }
+    }
+    text += ".end\n";
+
+    auto file = std::ofstream{path, std::ios::binary};
+    file.write(text.data(), static_cast<std::streamsize>(text.size()));
+}
+
+auto sameCircuit(mc::SpiceCircuit const& lhs, mc::SpiceCircuit const& rhs) -> bool
+{
+    auto const print = [](mc::SpiceCircuit const& c) {
+        auto out = std::ostringstream{};
+        out << c;
+        return out.str();
+    };
+    return print(lhs) == print(rhs);
+}
+
+auto sameNetlist(mc::SpiceNetlist const& lhs, mc::SpiceNetlist const& rhs) -> bool
+{
+    if (lhs.nodes.size() != rhs.nodes.size()) { return false; }
+    for (auto id = mc::NameTable::Id{0}; id < lhs.nodes.size(); ++id) {
+        if (lhs.nodes.name(id) != rhs.nodes.name(id)) { return false; }
+    }
+
+    auto const same = [](auto const& l, auto const& r) {
+        return l.kind == r.kind && l.name == r.name && l.positive == r.positive
+            && l.negative == r.negative && l.value == r.value;
+    };
+    return std::ranges::equal(lhs.elements, rhs.elements, same);
+}
+
+}  // namespace
+
+// usage: cxx_mna_benchmark [elements] [benchmark options]
+auto main(int argc, char** argv) -> int
+{
+    auto const elements = argc > 1 && argv[1][0] != '-' ? std::atoi(argv[1]) : 1'000'000;
+    auto const path     = std::filesystem::temp_directory_path() / "cxx_mna_benchmark.net";
+    generateNetlist(path, elements);
+
+    auto const megabytes = static_cast<double>(std::filesystem::file_size(path)) / 1e6;
+    std::printf("%s: %.1f MB\n", path.c_str(), megabytes);
+
+    auto const reference = mc::loadSpiceCircuit(path);
+    if (!sameCircuit(reference, mc::toSpiceCircuit(mc::loadSpiceNetlist(path)))) {
+        std::printf("loadSpiceNetlist differs from loadSpiceCircuit\n");
+        return EXIT_FAILURE;
+    }
+
+    // More chunks than cores is fine for checking the merge.
+    auto const serial   = mc::loadSpiceNetlist(path);
+    auto const parallel = mc::SpiceNetlistOptions{.threads = 0};
+    auto const chunked  = mc::SpiceNetlistOptions{.threads = 7, .minChunkSize = 1};
+    if (!sameNetlist(serial, mc::loadSpiceNetlist(path, chunked))) {
+        std::printf("parallel loadSpiceNetlist differs from the serial one\n");
+        return EXIT_FAILURE;
+    }
+
+    auto bench      = mc::Benchmark{argc, argv};
+    auto const rate = [megabytes](mc::BenchmarkResult const* result) {
+        if (result != nullptr) {
+            std::printf("  %.0f MB/s\n", megabytes / (result->median * 1e-9));
+        }
+    };
+
+    rate(bench.Run("netlist: loadSpiceCircuit", [&] {
+        auto circuit = mc::loadSpiceCircuit(path);
+        mc::DoNotOptimizeAway(circuit);
+    }));
+    rate(bench.Run("netlist: loadSpiceNetlist", [&] {
+        auto netlist = mc::loadSpiceNetlist(path);
+        mc::DoNotOptimizeAway(netlist);
+    }));
+    rate(bench.Run(fmt::format("netlist: loadSpiceNetlist, {} threads",
+                               std::thread::hardware_concurrency()),
+                   [&] {
+                       auto netlist = mc::loadSpiceNetlist(path, parallel);
+                       mc::DoNotOptimizeAway(netlist);
+                   }));
+    rate(bench.Run("netlist: loadSpiceNetlist + toSpiceCircuit", [&] {
+        auto circuit = mc::toSpiceCircuit(mc::loadSpiceNetlist(path));
+        mc::DoNotOptimizeAway(circuit);
+    }));
+
+    // The numbering only differs in the order of the branches, and the
+    // grid has a single one.
+    auto const compact = mc::toCompactCircuit(serial);
+    auto const fat     = mc::assembleDcSystem(reference);
+    auto const lean    = mc::assembleDcSystem(compact);
+    if (Eigen::SparseMatrix<double>{fat.matrix - lean.matrix}.norm() != 0.0
+        || fat.rhs != lean.rhs) {
+        std::printf("assembleDcSystem differs for the CompactCircuit\n");
+        return EXIT_FAILURE;
+    }
+
+    std::printf("SpiceCircuit: %zu bytes per element plus three strings\n",
+                sizeof(mc::SpiceElement));
+    std::printf("CompactCircuit: %zu bytes per element plus interned names\n",
+                3 * sizeof(mc::NameTable::Id) + sizeof(double));
+
+    bench.Run("assemble: SpiceCircuit", [&] {
+        auto system = mc::assembleDcSystem(reference);
+        mc::DoNotOptimizeAway(system);
+    });
+    bench.Run("assemble: CompactCircuit", [&] {
+        auto system = mc::assembleDcSystem(compact);
+        mc::DoNotOptimizeAway(system);
+    });
+
+    std::filesystem::remove(path);
+    return bench.Finish();
+}
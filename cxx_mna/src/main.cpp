@@ -1,28 +1,61 @@
-
+#include <mc/mna/dc_operating_point.hpp>
+#include <mc/mna/transient_solver.hpp>
+#include <mc/spice/detail/parse_spice_number.hpp>
 #include <mc/spice/spice_circuit.hpp>
 
-#include <Eigen/Dense>
+#include <fmt/format.h>
 
 #include <iostream>
 
-auto main(int argc, char const** argv) -> int
+namespace {
+
+// Node voltages as CSV, one row per step.
+auto runTransient(mc::SpiceCircuit const& circuit, double step, double stop) -> void
 {
-    auto A = Eigen::Matrix3d{};
-    A << 1, 2, 3, 4, 5, 6, 7, 8, 10;
-    std::cout << "Here is the matrix A:\n" << A << '\n';
+    auto solver       = mc::TransientSolver{circuit};
+    auto const& nodes = solver.system().nodes;
+
+    std::cout << "time";
+    for (auto id = mc::NameTable::Id{0}; id < nodes.size(); ++id) {
+        std::cout << fmt::format(",V({})", nodes.name(id));
+    }
+    std::cout << '\n';
+
+    auto const print = [&] {
+        std::cout << solver.time();
+        for (auto id = mc::NameTable::Id{0}; id < nodes.size(); ++id) {
+            std::cout << ',' << solver.solution()[id];
+        }
+        std::cout << '\n';
+    };
+
+    print();
+    while (solver.time() < stop - step * 0.5) {
+        solver.step(step);
+        print();
+    }
+}
 
-    auto b = Eigen::Vector3d{};
-    b << 3, 3, 4;
-    std::cout << "Here is the vector b:\n" << b << '\n';
+}  // namespace
 
-    auto x = A.colPivHouseholderQr().solve(b);
-    std::cout << "The solution is:\n" << x << '\n';
-    
-    if (argc != 2) { return EXIT_FAILURE; }
+// usage: cxx_mna <netlist> [step stop]
+auto main(int argc, char const** argv) -> int
+{
+    if (argc != 2 && argc != 4) { return EXIT_FAILURE; }
 
     auto circuit = mc::loadSpiceCircuit(argv[1]);
+
+    if (argc == 4) {
+        auto const step = mc::detail::parseSpiceNumber(argv[2]);
+        auto const stop = mc::detail::parseSpiceNumber(argv[3]);
+        runTransient(circuit, step, stop);
+        return EXIT_SUCCESS;
+    }
+
     std::cout << circuit << '\n';
 
-    return EXIT_SUCCESS;
+    auto const op = mc::solveDcOperatingPoint(circuit);
+    std::cout << op;
 
+    return EXIT_SUCCESS;
 }
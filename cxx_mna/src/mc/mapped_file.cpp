@@ -0,0 +1,63 @@
+#include "mapped_file.hpp"
+
+#include <fmt/format.h>
+
+#include <cerrno>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace mc {
+
+MappedFile::MappedFile(std::filesystem::path const& path)
+{
+    auto const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        throw std::system_error{errno, std::generic_category(), path.string()};
+    }
+
+    auto const fail = [&](char const* what) {
+        auto const error = errno;
+        ::close(fd);
+        throw std::system_error{
+            error, std::generic_category(), fmt::format("{}: {}", what, path.string())};
+    };
+
+    struct stat info{};
+    if (::fstat(fd, &info) == -1) { fail("fstat"); }
+
+    // mmap rejects a length of zero, an empty file is an empty view.
+    auto const size = static_cast<std::size_t>(info.st_size);
+    if (size != 0) {
+        auto* const data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) { fail("mmap"); }
+        ::madvise(data, size, MADV_SEQUENTIAL);
+        data_ = static_cast<char const*>(data);
+        size_ = size;
+    }
+
+    ::close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+    if (data_ != nullptr) { ::munmap(const_cast<char*>(data_), size_); }
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_{std::exchange(other.data_, nullptr)}
+    , size_{std::exchange(other.size_, 0)}
+{}
+
+auto MappedFile::operator=(MappedFile&& other) noexcept -> MappedFile&
+{
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+    return *this;
+}
+
+}  // namespace mc
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string_view>
+
+namespace mc {
+
+// Read-only memory mapping of a whole file. Throws std::system_error if the
+// file can not be opened or mapped.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    explicit MappedFile(std::filesystem::path const& path);
+    ~MappedFile();
+
+    MappedFile(MappedFile const&)                    = delete;
+    auto operator=(MappedFile const&) -> MappedFile& = delete;
+
+    MappedFile(MappedFile&& other) noexcept;
+    auto operator=(MappedFile&& other) noexcept -> MappedFile&;
+
+    [[nodiscard]] auto view() const noexcept -> std::string_view { return {data_, size_}; }
+
+    [[nodiscard]] auto size() const noexcept -> std::size_t { return size_; }
+
+private:
+    char const* data_{nullptr};
+    std::size_t size_{0};
+};
+
+}  // namespace mc
@@ -0,0 +1,70 @@
+#include "dc_operating_point.hpp"
+
+#include <fmt/format.h>
+
+#include <Eigen/OrderingMethods>
+#include <Eigen/SparseLU>
+
+#include <stdexcept>
+#include <utility>
+
+namespace mc {
+
+namespace {
+
+auto solve(MnaSystem system) -> DcOperatingPoint
+{
+    auto op   = DcOperatingPoint{};
+    op.system = std::move(system);
+    op.system.matrix.makeCompressed();
+
+    auto solver = Eigen::SparseLU<Eigen::SparseMatrix<double>, Eigen::COLAMDOrdering<int>>{};
+    solver.compute(op.system.matrix);
+    if (solver.info() != Eigen::Success) {
+        throw std::runtime_error{
+            fmt::format("dc operating point: singular matrix: {}", solver.lastErrorMessage())};
+    }
+
+    op.solution = solver.solve(op.system.rhs);
+    return op;
+}
+
+}  // namespace
+
+auto DcOperatingPoint::voltage(std::string_view node) const -> double
+{
+    auto const index = system.nodeIndex(node);
+    return index < 0 ? 0.0 : solution[index];
+}
+
+auto DcOperatingPoint::current(std::string_view element) const -> double
+{
+    return solution[system.branchIndex(element)];
+}
+
+auto solveDcOperatingPoint(SpiceCircuit const& circuit, DcOptions const& options)
+    -> DcOperatingPoint
+{
+    return solve(assembleDcSystem(circuit, options.gmin));
+}
+
+auto solveDcOperatingPoint(CompactCircuit const& circuit, DcOptions const& options)
+    -> DcOperatingPoint
+{
+    return solve(assembleDcSystem(circuit, options.gmin));
+}
+
+auto operator<<(std::ostream& out, DcOperatingPoint const& op) -> std::ostream&
+{
+    auto const& system = op.system;
+    for (auto id = NameTable::Id{0}; id < system.nodes.size(); ++id) {
+        out << fmt::format("V({}) = {}\n", system.nodes.name(id), op.solution[id]);
+    }
+    for (auto id = NameTable::Id{0}; id < system.branches.size(); ++id) {
+        auto const name = system.branches.name(id);
+        out << fmt::format("I({}) = {}\n", name, op.current(name));
+    }
+    return out;
+}
+
+}  // namespace mc
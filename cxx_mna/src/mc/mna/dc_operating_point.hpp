@@ -0,0 +1,41 @@
+#pragma once
+
+#include <mc/mna/mna_system.hpp>
+#include <mc/spice/compact_circuit.hpp>
+#include <mc/spice/spice_circuit.hpp>
+
+#include <Eigen/Core>
+
+#include <ostream>
+#include <string_view>
+
+namespace mc {
+
+struct DcOptions
+{
+    // Conductance from every node to ground, see assembleDcSystem.
+    double gmin{1e-12};
+};
+
+struct DcOperatingPoint
+{
+    MnaSystem system;
+    Eigen::VectorXd solution;
+
+    // 0 for ground. Throws std::out_of_range for unknown nodes.
+    [[nodiscard]] auto voltage(std::string_view node) const -> double;
+
+    // From positive to negative through a voltage source or inductor.
+    [[nodiscard]] auto current(std::string_view element) const -> double;
+};
+
+// Stamps circuit into a sparse MNA matrix and solves it with SparseLU.
+// Throws std::runtime_error if the matrix is singular.
+[[nodiscard]] auto solveDcOperatingPoint(SpiceCircuit const& circuit, DcOptions const& options = {})
+    -> DcOperatingPoint;
+[[nodiscard]] auto solveDcOperatingPoint(CompactCircuit const& circuit,
+                                         DcOptions const& options = {}) -> DcOperatingPoint;
+
+auto operator<<(std::ostream& out, DcOperatingPoint const& op) -> std::ostream&;
+
+}  // namespace mc
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <Eigen/SparseCore>
+
+#include <vector>
+
+namespace mc::detail {
+
+// Collects matrix entries as triplets. Index -1 is ground, whose row and
+// column are not part of the system, so entries touching it are dropped.
+// Duplicates are summed by setFromTriplets.
+struct MnaStamper
+{
+    static constexpr auto ground = -1;
+
+    std::vector<Eigen::Triplet<double>> triplets;
+
+    auto add(int row, int col, double value) -> void
+    {
+        if (row == ground || col == ground) { return; }
+        triplets.emplace_back(row, col, value);
+    }
+
+    // A conductance g between nodes a and b.
+    auto conductance(int a, int b, double g) -> void
+    {
+        add(a, a, g);
+        add(b, b, g);
+        add(a, b, -g);
+        add(b, a, -g);
+    }
+
+    // Couples the current unknown of branch k into the KCL rows of a and b,
+    // and a and b into the branch equation v(a) - v(b) = ... in row k.
+    auto branch(int a, int b, int k) -> void
+    {
+        add(a, k, 1.0);
+        add(b, k, -1.0);
+        add(k, a, 1.0);
+        add(k, b, -1.0);
+    }
+};
+
+}  // namespace mc::detail
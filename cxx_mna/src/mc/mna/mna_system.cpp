@@ -0,0 +1,199 @@
+#include "mna_system.hpp"
+
+#include <mc/mna/detail/mna_stamper.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cctype>
+#include <stdexcept>
+#include <type_traits>
+#include <variant>
+
+namespace mc {
+
+namespace {
+
+template<typename Element>
+constexpr auto hasBranch = std::is_same_v<Element, SpiceVoltageSource>
+                        || std::is_same_v<Element, SpiceInductor>;
+
+auto stampDc(MnaSystem& system, detail::MnaStamper& stamper, SpiceElement const& element)
+    -> void
+{
+    std::visit(
+        [&](auto const& e) {
+            using Element = std::decay_t<decltype(e)>;
+
+            auto const a = system.nodeIndex(e.positive);
+            auto const b = system.nodeIndex(e.negative);
+
+            if constexpr (std::is_same_v<Element, SpiceResistor>) {
+                if (e.ohm == 0.0) {
+                    throw std::invalid_argument{fmt::format("{}: zero resistance", e.name)};
+                }
+                stamper.conductance(a, b, 1.0 / e.ohm);
+            } else if constexpr (std::is_same_v<Element, SpiceVoltageSource>) {
+                auto const k = system.branchIndex(e.name);
+                stamper.branch(a, b, k);
+                system.rhs[k] = e.voltage;
+            } else if constexpr (std::is_same_v<Element, SpiceInductor>) {
+                stamper.branch(a, b, system.branchIndex(e.name));
+            }
+        },
+        element
+    );
+}
+
+}  // namespace
+
+auto MnaSystem::nodeIndex(std::string_view name) const -> int
+{
+    if (isGroundNode(name)) { return detail::MnaStamper::ground; }
+    auto const id = nodes.find(name);
+    if (!id) { throw std::out_of_range{fmt::format("unknown node: {}", name)}; }
+    return static_cast<int>(*id);
+}
+
+auto MnaSystem::branchIndex(std::string_view element) const -> int
+{
+    auto const id = branches.find(element);
+    if (!id) { throw std::out_of_range{fmt::format("no branch current: {}", element)}; }
+    return static_cast<int>(nodes.size() + *id);
+}
+
+auto isGroundNode(std::string_view name) -> bool
+{
+    auto const equalIgnoreCase = [](char l, char r) {
+        return std::toupper(static_cast<unsigned char>(l)) == r;
+    };
+    return name == "0" || std::ranges::equal(name, std::string_view{"GND"}, equalIgnoreCase);
+}
+
+auto makeMnaSystem(SpiceCircuit const& circuit) -> MnaSystem
+{
+    auto system = MnaSystem{};
+    for (auto const& element : circuit.elements) {
+        std::visit(
+            [&system](auto const& e) {
+                using Element = std::decay_t<decltype(e)>;
+
+                if (!isGroundNode(e.positive)) { system.nodes.intern(e.positive); }
+                if (!isGroundNode(e.negative)) { system.nodes.intern(e.negative); }
+
+                if constexpr (hasBranch<Element>) {
+                    auto const before = system.branches.size();
+                    system.branches.intern(e.name);
+                    if (system.branches.size() == before) {
+                        throw std::invalid_argument{
+                            fmt::format("duplicate element name: {}", e.name)};
+                    }
+                }
+            },
+            element
+        );
+    }
+
+    system.matrix.resize(system.size(), system.size());
+    system.rhs = Eigen::VectorXd::Zero(system.size());
+    return system;
+}
+
+auto assembleDcSystem(SpiceCircuit const& circuit, double gmin) -> MnaSystem
+{
+    auto system  = makeMnaSystem(circuit);
+    auto stamper = detail::MnaStamper{};
+    stamper.triplets.reserve(circuit.elements.size() * 4 + system.nodes.size());
+
+    for (auto const& element : circuit.elements) { stampDc(system, stamper, element); }
+
+    auto const numNodes = static_cast<int>(system.nodes.size());
+    if (gmin != 0.0) {
+        for (auto node = 0; node < numNodes; ++node) { stamper.add(node, node, gmin); }
+    }
+
+    system.matrix.setFromTriplets(stamper.triplets.begin(), stamper.triplets.end());
+    return system;
+}
+
+auto makeMnaSystem(CompactCircuit const& circuit) -> MnaSystem
+{
+    auto system = MnaSystem{};
+    system.nodes.reserve(circuit.nodes.size());
+    for (auto id = NameTable::Id{0}; id < circuit.nodes.size(); ++id) {
+        auto const name = circuit.nodes.name(id);
+        if (!isGroundNode(name)) { system.nodes.intern(name); }
+    }
+
+    auto const addBranches = [&](CompactElements const& elements) {
+        for (auto const id : elements.names) {
+            auto const name   = circuit.names.name(id);
+            auto const before = system.branches.size();
+            system.branches.intern(name);
+            if (system.branches.size() == before) {
+                throw std::invalid_argument{
+                    fmt::format("duplicate element name: {}", name)};
+            }
+        }
+    };
+    addBranches(circuit.voltageSources);
+    addBranches(circuit.inductors);
+
+    system.matrix.resize(system.size(), system.size());
+    system.rhs = Eigen::VectorXd::Zero(system.size());
+    return system;
+}
+
+auto mnaNodeIndices(CompactCircuit const& circuit) -> std::vector<int>
+{
+    auto indices = std::vector<int>(circuit.nodes.size());
+    auto next    = 0;
+    for (auto id = NameTable::Id{0}; id < circuit.nodes.size(); ++id) {
+        auto const ground = isGroundNode(circuit.nodes.name(id));
+        indices[id]       = ground ? detail::MnaStamper::ground : next++;
+    }
+    return indices;
+}
+
+auto assembleDcSystem(CompactCircuit const& circuit, double gmin) -> MnaSystem
+{
+    auto system       = makeMnaSystem(circuit);
+    auto const index  = mnaNodeIndices(circuit);
+    auto const& r     = circuit.resistors;
+    auto const& v     = circuit.voltageSources;
+    auto const& l     = circuit.inductors;
+    auto const nodes  = static_cast<int>(system.nodes.size());
+    auto const vCount = static_cast<int>(v.size());
+
+    auto stamper = detail::MnaStamper{};
+    stamper.triplets.reserve((r.size() + v.size() + l.size()) * 4 + system.nodes.size());
+
+    for (std::size_t i = 0; i < r.size(); ++i) {
+        if (r.values[i] == 0.0) {
+            throw std::invalid_argument{
+                fmt::format("{}: zero resistance", circuit.names.name(r.names[i]))};
+        }
+        stamper.conductance(index[r.positive[i]], index[r.negative[i]], 1.0 / r.values[i]);
+    }
+
+    for (std::size_t i = 0; i < v.size(); ++i) {
+        auto const k = nodes + static_cast<int>(i);
+        stamper.branch(index[v.positive[i]], index[v.negative[i]], k);
+        system.rhs[k] = v.values[i];
+    }
+
+    for (std::size_t i = 0; i < l.size(); ++i) {
+        auto const k = nodes + vCount + static_cast<int>(i);
+        stamper.branch(index[l.positive[i]], index[l.negative[i]], k);
+    }
+
+    if (gmin != 0.0) {
+        for (auto node = 0; node < nodes; ++node) { stamper.add(node, node, gmin); }
+    }
+
+    system.matrix.setFromTriplets(stamper.triplets.begin(), stamper.triplets.end());
+    return system;
+}
+
+}  // namespace mc
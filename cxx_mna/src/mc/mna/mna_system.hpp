@@ -0,0 +1,58 @@
+#pragma once
+
+#include <mc/name_table.hpp>
+#include <mc/spice/compact_circuit.hpp>
+#include <mc/spice/spice_circuit.hpp>
+
+#include <Eigen/Core>
+#include <Eigen/SparseCore>
+
+#include <string_view>
+#include <vector>
+
+namespace mc {
+
+// Modified nodal analysis: one unknown per non-ground node voltage, followed
+// by one unknown per branch current. Voltage sources and inductors have a
+// branch current, resistors and capacitors do not.
+struct MnaSystem
+{
+    NameTable nodes;
+    NameTable branches;
+    Eigen::SparseMatrix<double> matrix;
+    Eigen::VectorXd rhs;
+
+    [[nodiscard]] auto size() const -> Eigen::Index
+    {
+        return static_cast<Eigen::Index>(nodes.size() + branches.size());
+    }
+
+    // Matrix index of a node, -1 for ground.
+    [[nodiscard]] auto nodeIndex(std::string_view name) const -> int;
+
+    // Matrix index of the current through a voltage source or inductor.
+    [[nodiscard]] auto branchIndex(std::string_view element) const -> int;
+};
+
+// "0" and "GND", in any case.
+[[nodiscard]] auto isGroundNode(std::string_view name) -> bool;
+
+// Numbers the nodes and branches of circuit without stamping anything.
+[[nodiscard]] auto makeMnaSystem(SpiceCircuit const& circuit) -> MnaSystem;
+
+// Same node numbering as for the SpiceCircuit, but the branches are all
+// voltage sources followed by all inductors.
+[[nodiscard]] auto makeMnaSystem(CompactCircuit const& circuit) -> MnaSystem;
+
+// Matrix index of every node id of circuit, -1 for ground.
+[[nodiscard]] auto mnaNodeIndices(CompactCircuit const& circuit) -> std::vector<int>;
+
+// The system for the DC operating point: capacitors are open, inductors are
+// shorts, i.e. 0 V sources. gmin is a conductance from every node to
+// ground, so that a node only reached through capacitors is not floating.
+[[nodiscard]] auto assembleDcSystem(SpiceCircuit const& circuit, double gmin = 1e-12)
+    -> MnaSystem;
+[[nodiscard]] auto assembleDcSystem(CompactCircuit const& circuit, double gmin = 1e-12)
+    -> MnaSystem;
+
+}  // namespace mc
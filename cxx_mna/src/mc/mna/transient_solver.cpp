@@ -0,0 +1,220 @@
+#include "transient_solver.hpp"
+
+#include <mc/mna/detail/mna_stamper.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <variant>
+
+namespace mc {
+
+namespace {
+
+// Position of (row, col) in the value array of a compressed column major
+// matrix that has the entry in its pattern.
+auto entryOffset(Eigen::SparseMatrix<double> const& matrix, int row, int col)
+    -> std::ptrdiff_t
+{
+    auto const* inner = matrix.innerIndexPtr();
+    auto const* first = inner + matrix.outerIndexPtr()[col];
+    auto const* last  = inner + matrix.outerIndexPtr()[col + 1];
+    return std::lower_bound(first, last, row) - inner;
+}
+
+}  // namespace
+
+TransientSolver::TransientSolver(SpiceCircuit const& circuit,
+                                 TransientOptions const& options)
+    : system_{assembleDcSystem(circuit, options.gmin)}
+    , method_{options.method}
+{
+    for (auto const& element : circuit.elements) {
+        std::visit(
+            [&](auto const& e) {
+                using Element = std::decay_t<decltype(e)>;
+
+                if constexpr (std::is_same_v<Element, SpiceCapacitor>) {
+                    auto const a = system_.nodeIndex(e.positive);
+                    auto const b = system_.nodeIndex(e.negative);
+                    capacitors_.push_back({a, b, e.farad, 0.0, 0.0});
+                } else if constexpr (std::is_same_v<Element, SpiceInductor>) {
+                    auto const a = system_.nodeIndex(e.positive);
+                    auto const b = system_.nodeIndex(e.negative);
+                    auto const k = system_.branchIndex(e.name);
+                    inductors_.push_back({a, b, k, e.henry, 0.0, 0.0});
+                }
+            },
+            element
+        );
+    }
+
+    setUp(options);
+}
+
+TransientSolver::TransientSolver(CompactCircuit const& circuit,
+                                 TransientOptions const& options)
+    : system_{assembleDcSystem(circuit, options.gmin)}
+    , method_{options.method}
+{
+    auto const index = mnaNodeIndices(circuit);
+
+    auto const& c = circuit.capacitors;
+    capacitors_.reserve(c.size());
+    for (std::size_t i = 0; i < c.size(); ++i) {
+        auto const a = index[c.positive[i]];
+        auto const b = index[c.negative[i]];
+        capacitors_.push_back({a, b, c.values[i], 0.0, 0.0});
+    }
+
+    // Branches as numbered by makeMnaSystem(CompactCircuit const&).
+    auto const& l    = circuit.inductors;
+    auto const first = system_.nodes.size() + circuit.voltageSources.size();
+    inductors_.reserve(l.size());
+    for (std::size_t i = 0; i < l.size(); ++i) {
+        auto const a = index[l.positive[i]];
+        auto const b = index[l.negative[i]];
+        auto const k = static_cast<int>(first + i);
+        inductors_.push_back({a, b, k, l.values[i], 0.0, 0.0});
+    }
+
+    setUp(options);
+}
+
+auto TransientSolver::setUp(TransientOptions const& options) -> void
+{
+    // The DC system is the static part: capacitors are open and inductors
+    // have their branch row with no impedance yet.
+    auto const dc = Eigen::SparseMatrix<double>{system_.matrix};
+    sources_      = system_.rhs;
+
+    auto dynamic = detail::MnaStamper{};
+    dynamic.triplets.reserve(capacitors_.size() * 4 + inductors_.size());
+    for (auto const& c : capacitors_) {
+        dynamic.conductance(c.positive, c.negative, c.farad);
+    }
+    for (auto const& l : inductors_) { dynamic.add(l.branch, l.branch, -l.henry); }
+
+    // One pattern for both parts, so that every step size refactors the same
+    // structure and the symbolic analysis stays valid.
+    auto pattern = std::vector<Eigen::Triplet<double>>{};
+    pattern.reserve(static_cast<std::size_t>(dc.nonZeros()) + dynamic.triplets.size());
+    for (auto col = 0; col < dc.outerSize(); ++col) {
+        for (auto it = Eigen::SparseMatrix<double>::InnerIterator{dc, col}; it; ++it) {
+            pattern.emplace_back(static_cast<int>(it.row()), col, 0.0);
+        }
+    }
+    for (auto const& t : dynamic.triplets) { pattern.emplace_back(t.row(), t.col(), 0.0); }
+
+    system_.matrix.setFromTriplets(pattern.begin(), pattern.end());
+    system_.matrix.makeCompressed();
+
+    static_.assign(static_cast<std::size_t>(system_.matrix.nonZeros()), 0.0);
+    dynamic_.assign(static_.size(), 0.0);
+    for (auto col = 0; col < dc.outerSize(); ++col) {
+        for (auto it = Eigen::SparseMatrix<double>::InnerIterator{dc, col}; it; ++it) {
+            auto const row = static_cast<int>(it.row());
+            static_[entryOffset(system_.matrix, row, col)] += it.value();
+        }
+    }
+    for (auto const& t : dynamic.triplets) {
+        dynamic_[entryOffset(system_.matrix, t.row(), t.col())] += t.value();
+    }
+
+    lu_.analyzePattern(system_.matrix);
+
+    solution_          = Eigen::VectorXd::Zero(system_.size());
+    backwardEulerNext_ = !options.startFromDc;
+    if (options.startFromDc) {
+        auto dcLu = decltype(lu_){};
+        dcLu.compute(dc);
+        if (dcLu.info() != Eigen::Success) {
+            throw std::runtime_error{
+                fmt::format("transient: singular dc matrix: {}", dcLu.lastErrorMessage())};
+        }
+        solution_ = dcLu.solve(sources_);
+
+        for (auto& c : capacitors_) { c.voltage = across(c.positive, c.negative); }
+        for (auto& l : inductors_) { l.current = solution_[l.branch]; }
+    }
+}
+
+auto TransientSolver::step(double h) -> void
+{
+    if (!(h > 0.0)) {
+        throw std::invalid_argument{fmt::format("transient: bad step {}", h)};
+    }
+
+    auto const trapezoidal = method_ == IntegrationMethod::trapezoidal
+                          && !backwardEulerNext_;
+    auto const scale       = (trapezoidal ? 2.0 : 1.0) / h;
+    if (scale != factorizedScale_) { factorize(scale); }
+    backwardEulerNext_ = false;
+
+    // History terms of the companion models. Backward Euler:
+    //   i = g (v - v') with g = C / h,   v = z (i - i') with z = L / h
+    // Trapezoidal:
+    //   i = g (v - v') - i' with g = 2C / h,   v = z (i - i') - v' with z = 2L / h
+    rhs_ = sources_;
+    for (auto const& c : capacitors_) {
+        auto const history = scale * c.farad * c.voltage + (trapezoidal ? c.current : 0.0);
+        if (c.positive >= 0) { rhs_[c.positive] += history; }
+        if (c.negative >= 0) { rhs_[c.negative] -= history; }
+    }
+    for (auto const& l : inductors_) {
+        rhs_[l.branch] = -scale * l.henry * l.current - (trapezoidal ? l.voltage : 0.0);
+    }
+
+    solution_ = lu_.solve(rhs_);
+    time_ += h;
+
+    for (auto& c : capacitors_) {
+        auto const voltage = across(c.positive, c.negative);
+        auto const current = scale * c.farad * (voltage - c.voltage);
+        c.current          = trapezoidal ? current - c.current : current;
+        c.voltage          = voltage;
+    }
+    for (auto& l : inductors_) {
+        l.current = solution_[l.branch];
+        l.voltage = across(l.positive, l.negative);
+    }
+}
+
+auto TransientSolver::voltage(std::string_view node) const -> double
+{
+    auto const index = system_.nodeIndex(node);
+    return index < 0 ? 0.0 : solution_[index];
+}
+
+auto TransientSolver::current(std::string_view element) const -> double
+{
+    return solution_[system_.branchIndex(element)];
+}
+
+auto TransientSolver::across(int positive, int negative) const -> double
+{
+    auto const a = positive < 0 ? 0.0 : solution_[positive];
+    auto const b = negative < 0 ? 0.0 : solution_[negative];
+    return a - b;
+}
+
+auto TransientSolver::factorize(double scale) -> void
+{
+    auto* values = system_.matrix.valuePtr();
+    for (std::size_t i = 0; i < static_.size(); ++i) {
+        values[i] = static_[i] + scale * dynamic_[i];
+    }
+
+    lu_.factorize(system_.matrix);
+    if (lu_.info() != Eigen::Success) {
+        throw std::runtime_error{
+            fmt::format("transient: singular matrix: {}", lu_.lastErrorMessage())};
+    }
+
+    factorizedScale_ = scale;
+    ++factorizations_;
+}
+
+}  // namespace mc
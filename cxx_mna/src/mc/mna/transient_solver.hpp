@@ -0,0 +1,125 @@
+#pragma once
+
+#include <mc/mna/mna_system.hpp>
+#include <mc/spice/compact_circuit.hpp>
+#include <mc/spice/spice_circuit.hpp>
+
+#include <Eigen/Core>
+#include <Eigen/OrderingMethods>
+#include <Eigen/SparseCore>
+#include <Eigen/SparseLU>
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace mc {
+
+enum struct IntegrationMethod
+{
+    backwardEuler,
+    trapezoidal,
+};
+
+struct TransientOptions
+{
+    IntegrationMethod method{IntegrationMethod::trapezoidal};
+
+    // Conductance from every node to ground, see assembleDcSystem.
+    double gmin{1e-12};
+
+    // Start from the DC operating point, otherwise from all zero. The
+    // capacitor currents of a zero start are not consistent with the circuit,
+    // so the first step is then taken with backward Euler.
+    bool startFromDc{true};
+};
+
+// Transient analysis with companion models for capacitors and inductors.
+//
+// Only the capacitor and inductor entries of the matrix depend on the step
+// size h, and all of them scale with 1/h. The matrix is therefore kept as
+// static + (k / h) * dynamic on one fixed sparsity pattern. The fill-reducing
+// ordering and symbolic analysis run once in the constructor; a new step
+// size costs one numeric refactorization, and a step of the same size as the
+// previous one only updates the right-hand side and does one solve.
+class TransientSolver
+{
+public:
+    explicit TransientSolver(SpiceCircuit const& circuit,
+                             TransientOptions const& options = {});
+    explicit TransientSolver(CompactCircuit const& circuit,
+                             TransientOptions const& options = {});
+
+    TransientSolver(TransientSolver const&)                    = delete;
+    auto operator=(TransientSolver const&) -> TransientSolver& = delete;
+
+    // Advances the solution by h seconds.
+    auto step(double h) -> void;
+
+    [[nodiscard]] auto time() const noexcept -> double { return time_; }
+
+    [[nodiscard]] auto solution() const noexcept -> Eigen::VectorXd const&
+    {
+        return solution_;
+    }
+
+    [[nodiscard]] auto system() const noexcept -> MnaSystem const& { return system_; }
+
+    // Numeric factorizations so far, one per change of step size.
+    [[nodiscard]] auto factorizations() const noexcept -> std::size_t
+    {
+        return factorizations_;
+    }
+
+    // 0 for ground. Throws std::out_of_range for unknown nodes.
+    [[nodiscard]] auto voltage(std::string_view node) const -> double;
+
+    // From positive to negative through a voltage source or inductor.
+    [[nodiscard]] auto current(std::string_view element) const -> double;
+
+private:
+    struct Capacitor
+    {
+        int positive;
+        int negative;
+        double farad;
+        double voltage;
+        double current;
+    };
+
+    struct Inductor
+    {
+        int positive;
+        int negative;
+        int branch;
+        double henry;
+        double voltage;
+        double current;
+    };
+
+    // Everything after filling capacitors_ and inductors_.
+    auto setUp(TransientOptions const& options) -> void;
+
+    [[nodiscard]] auto across(int positive, int negative) const -> double;
+    auto factorize(double scale) -> void;
+
+    MnaSystem system_;
+    IntegrationMethod method_;
+    std::vector<Capacitor> capacitors_;
+    std::vector<Inductor> inductors_;
+
+    // Values of the static and dynamic parts, on the pattern of the matrix.
+    std::vector<double> static_;
+    std::vector<double> dynamic_;
+
+    Eigen::SparseLU<Eigen::SparseMatrix<double>, Eigen::COLAMDOrdering<int>> lu_;
+    Eigen::VectorXd sources_;
+    Eigen::VectorXd rhs_;
+    Eigen::VectorXd solution_;
+    double time_{0.0};
+    double factorizedScale_{0.0};
+    bool backwardEulerNext_{false};
+    std::size_t factorizations_{0};
+};
+
+}  // namespace mc
@@ -0,0 +1,99 @@
+#include "name_table.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+
+namespace mc {
+
+NameTable::NameTable(NameTable&& other)
+    : chars_{std::exchange(other.chars_, {})}
+    , offsets_{std::exchange(other.offsets_, {0})}
+    , slots_{std::exchange(other.slots_, {})}
+{
+}
+
+auto NameTable::operator=(NameTable&& other) -> NameTable&
+{
+    if (this != &other) {
+        chars_   = std::exchange(other.chars_, {});
+        offsets_ = std::exchange(other.offsets_, {0});
+        slots_   = std::exchange(other.slots_, {});
+    }
+    return *this;
+}
+
+auto NameTable::intern(std::string_view name) -> Id
+{
+    if (slots_.size() < (size() + 1) * 2) {
+        rehash(std::max<std::size_t>(16, slots_.size() * 2));
+    }
+
+    auto const h = hash(name);
+    auto const s = slot(name, h);
+    if (slots_[s].id != empty) { return slots_[s].id; }
+
+    auto const id = static_cast<Id>(size());
+    chars_.append(name);
+    offsets_.push_back(chars_.size());
+    slots_[s] = {id, static_cast<std::uint32_t>(h >> 32U)};
+    return id;
+}
+
+auto NameTable::find(std::string_view name) const -> std::optional<Id>
+{
+    if (slots_.empty()) { return std::nullopt; }
+    auto const id = slots_[slot(name, hash(name))].id;
+    if (id == empty) { return std::nullopt; }
+    return id;
+}
+
+auto NameTable::name(Id id) const -> std::string_view
+{
+    if (id >= size()) { throw std::out_of_range{fmt::format("invalid name id: {}", id)}; }
+    return view(id);
+}
+
+auto NameTable::reserve(std::size_t count) -> void
+{
+    if (slots_.size() < count * 2) { rehash(std::bit_ceil(count * 2)); }
+    offsets_.reserve(count + 1);
+}
+
+auto NameTable::hash(std::string_view name) noexcept -> std::size_t
+{
+    return std::hash<std::string_view>{}(name);
+}
+
+auto NameTable::slot(std::string_view name, std::size_t hash) const noexcept -> std::size_t
+{
+    auto const mask = slots_.size() - 1;
+    auto const tag  = static_cast<std::uint32_t>(hash >> 32U);
+    for (auto s = hash & mask;; s = (s + 1) & mask) {
+        auto const [id, slotTag] = slots_[s];
+        if (id == empty || (slotTag == tag && view(id) == name)) { return s; }
+    }
+}
+
+auto NameTable::view(Id id) const noexcept -> std::string_view
+{
+    return std::string_view{chars_}.substr(offsets_[id], offsets_[id + 1] - offsets_[id]);
+}
+
+auto NameTable::rehash(std::size_t capacity) -> void
+{
+    slots_.assign(capacity, Slot{empty, 0});
+    auto const mask = capacity - 1;
+    for (auto id = Id{0}; id < size(); ++id) {
+        auto const h = hash(view(id));
+        auto s       = h & mask;
+        while (slots_[s].id != empty) { s = (s + 1) & mask; }
+        slots_[s] = {id, static_cast<std::uint32_t>(h >> 32U)};
+    }
+}
+
+}  // namespace mc
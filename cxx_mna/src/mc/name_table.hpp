@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace mc {
+
+// Interns names into dense ids 0, 1, 2, ... in order of first appearance.
+//
+// The names are stored back to back in one buffer and looked up through an
+// open addressing table of ids with linear probing, so interning a known
+// name does not allocate and touches two or three cache lines.
+class NameTable
+{
+public:
+    using Id = std::uint32_t;
+
+    NameTable() = default;
+
+    NameTable(NameTable const&)                    = delete;
+    auto operator=(NameTable const&) -> NameTable& = delete;
+
+    // Leave other as an empty table, whose offsets_ still holds the leading 0.
+    NameTable(NameTable&& other);
+    auto operator=(NameTable&& other) -> NameTable&;
+
+    // Returns the id of name, adding it if it is new.
+    auto intern(std::string_view name) -> Id;
+
+    [[nodiscard]] auto find(std::string_view name) const -> std::optional<Id>;
+
+    // Valid until the next call to intern. Throws std::out_of_range.
+    [[nodiscard]] auto name(Id id) const -> std::string_view;
+
+    [[nodiscard]] auto size() const noexcept -> std::size_t { return offsets_.size() - 1; }
+
+    auto reserve(std::size_t count) -> void;
+
+private:
+    // The upper half of the hash is kept next to the id, so most probes of a
+    // name that is not there never look at the characters.
+    struct Slot
+    {
+        Id id;
+        std::uint32_t tag;
+    };
+
+    static constexpr auto empty = ~Id{0};
+
+    [[nodiscard]] static auto hash(std::string_view name) noexcept -> std::size_t;
+
+    // Slot holding name, or the empty slot where it would go.
+    [[nodiscard]] auto slot(std::string_view name, std::size_t hash) const noexcept
+        -> std::size_t;
+    [[nodiscard]] auto view(Id id) const noexcept -> std::string_view;
+    auto rehash(std::size_t capacity) -> void;
+
+    std::string chars_;
+    std::vector<std::size_t> offsets_{0};  // name i is [offsets_[i], offsets_[i + 1])
+    std::vector<Slot> slots_;  // power of two size, at most half full
+};
+
+}  // namespace mc
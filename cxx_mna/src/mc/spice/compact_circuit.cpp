@@ -0,0 +1,96 @@
+#include "compact_circuit.hpp"
+
+#include <fmt/format.h>
+
+#include <stdexcept>
+#include <type_traits>
+#include <variant>
+
+namespace mc {
+
+namespace {
+
+auto elementsOf(CompactCircuit& circuit, char kind) -> CompactElements&
+{
+    switch (kind) {
+        case SpiceResistor::token: return circuit.resistors;
+        case SpiceCapacitor::token: return circuit.capacitors;
+        case SpiceInductor::token: return circuit.inductors;
+        case SpiceVoltageSource::token: return circuit.voltageSources;
+        default: throw std::logic_error{fmt::format("unknown element kind: {}", kind)};
+    }
+}
+
+}  // namespace
+
+auto CompactElements::add(NameTable::Id name,
+                          NameTable::Id pos,
+                          NameTable::Id neg,
+                          double value) -> void
+{
+    names.push_back(name);
+    positive.push_back(pos);
+    negative.push_back(neg);
+    values.push_back(value);
+}
+
+auto CompactElements::reserve(std::size_t count) -> void
+{
+    names.reserve(count);
+    positive.reserve(count);
+    negative.reserve(count);
+    values.reserve(count);
+}
+
+auto toCompactCircuit(SpiceNetlist const& netlist) -> CompactCircuit
+{
+    auto compact  = CompactCircuit{};
+    compact.title = std::string{netlist.title};
+
+    compact.nodes.reserve(netlist.nodes.size());
+    for (auto id = NameTable::Id{0}; id < netlist.nodes.size(); ++id) {
+        compact.nodes.intern(netlist.nodes.name(id));
+    }
+
+    compact.names.reserve(netlist.elements.size());
+    for (auto const& e : netlist.elements) {
+        auto const name = compact.names.intern(e.name);
+        elementsOf(compact, e.kind).add(name, e.positive, e.negative, e.value);
+    }
+
+    return compact;
+}
+
+auto toCompactCircuit(SpiceCircuit const& circuit) -> CompactCircuit
+{
+    auto compact  = CompactCircuit{};
+    compact.title = circuit.title;
+    compact.names.reserve(circuit.elements.size());
+
+    for (auto const& element : circuit.elements) {
+        std::visit(
+            [&compact](auto const& e) {
+                using Element = std::decay_t<decltype(e)>;
+
+                auto const name     = compact.names.intern(e.name);
+                auto const positive = compact.nodes.intern(e.positive);
+                auto const negative = compact.nodes.intern(e.negative);
+
+                if constexpr (std::is_same_v<Element, SpiceResistor>) {
+                    compact.resistors.add(name, positive, negative, e.ohm);
+                } else if constexpr (std::is_same_v<Element, SpiceCapacitor>) {
+                    compact.capacitors.add(name, positive, negative, e.farad);
+                } else if constexpr (std::is_same_v<Element, SpiceInductor>) {
+                    compact.inductors.add(name, positive, negative, e.henry);
+                } else if constexpr (std::is_same_v<Element, SpiceVoltageSource>) {
+                    compact.voltageSources.add(name, positive, negative, e.voltage);
+                }
+            },
+            element
+        );
+    }
+
+    return compact;
+}
+
+}  // namespace mc
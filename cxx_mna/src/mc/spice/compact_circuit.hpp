@@ -0,0 +1,47 @@
+#pragma once
+
+#include <mc/name_table.hpp>
+#include <mc/spice/spice_circuit.hpp>
+#include <mc/spice/spice_netlist.hpp>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace mc {
+
+// Elements of one kind as a structure of arrays, element i is index i of
+// every array.
+struct CompactElements
+{
+    std::vector<NameTable::Id> names;     // in CompactCircuit::names
+    std::vector<NameTable::Id> positive;  // in CompactCircuit::nodes
+    std::vector<NameTable::Id> negative;  // in CompactCircuit::nodes
+    std::vector<double> values;
+
+    [[nodiscard]] auto size() const noexcept -> std::size_t { return values.size(); }
+
+    auto add(NameTable::Id name, NameTable::Id pos, NameTable::Id neg, double value)
+        -> void;
+    auto reserve(std::size_t count) -> void;
+};
+
+// A circuit for the solvers to walk: 20 bytes per element, with node and
+// element names interned once. The order of elements within a kind is kept,
+// the order between kinds is not.
+struct CompactCircuit
+{
+    std::string title;
+    NameTable nodes;  // in order of first appearance, ground included
+    NameTable names;
+    CompactElements resistors;       // ohm
+    CompactElements capacitors;      // farad
+    CompactElements inductors;       // henry
+    CompactElements voltageSources;  // volt
+};
+
+// Node ids are the same as those of the netlist.
+[[nodiscard]] auto toCompactCircuit(SpiceNetlist const& netlist) -> CompactCircuit;
+[[nodiscard]] auto toCompactCircuit(SpiceCircuit const& circuit) -> CompactCircuit;
+
+}  // namespace mc
@@ -5,32 +5,40 @@
 
 #include <algorithm>
 #include <array>
+#include <cctype>
+#include <charconv>
+#include <cmath>
 #include <sstream>
 #include <string_view>
+#include <system_error>
 
 namespace mc::detail {
 
-auto parseSpiceNumber(std::string const& str) -> double
+namespace {
+
+struct Magnitude
 {
-    struct Magnitude
-    {
-        std::string_view suffix;
-        double multiplier;
-    };
+    std::string_view suffix;
+    double multiplier;
+};
 
-    static constexpr auto magnitudes = std::array<Magnitude, 10>{
-        Magnitude{  "T", 1e+12}, //   Tera
-        Magnitude{  "G", 1e+09}, //   Giga
-        Magnitude{  "X", 1e+06}, //   Mega
-        Magnitude{"MEG", 1e+06}, //   Mega
-        Magnitude{  "K", 1e+03}, //   Kilo
-        Magnitude{  "M", 1e-03}, //   Milli
-        Magnitude{  "U", 1e-06}, //   Micro
-        Magnitude{  "N", 1e-09}, //   Nano
-        Magnitude{  "P", 1e-12}, //   Pico
-        Magnitude{  "F", 1e-15}, //   Femto
-    };
+constexpr auto magnitudes = std::array<Magnitude, 10>{
+    Magnitude{  "T", 1e+12}, //   Tera
+    Magnitude{  "G", 1e+09}, //   Giga
+    Magnitude{  "X", 1e+06}, //   Mega
+    Magnitude{"MEG", 1e+06}, //   Mega
+    Magnitude{  "K", 1e+03}, //   Kilo
+    Magnitude{  "M", 1e-03}, //   Milli
+    Magnitude{  "U", 1e-06}, //   Micro
+    Magnitude{  "N", 1e-09}, //   Nano
+    Magnitude{  "P", 1e-12}, //   Pico
+    Magnitude{  "F", 1e-15}, //   Femto
+};
 
+}  // namespace
+
+auto parseSpiceNumber(std::string const& str) -> double
+{
     auto in     = std::istringstream{str};
     auto val    = readFromStream<double>(in);
     auto suffix = readFromStream<std::string>(in);
@@ -43,4 +51,38 @@ auto parseSpiceNumber(std::string const& str) -> double
     return val * found->multiplier;
 }
 
+auto tryParseSpiceNumber(std::string_view str) -> std::optional<double>
+{
+    auto const* first = str.data();
+    auto const* last  = first + str.size();
+
+    // Unlike operator>>, from_chars does not take a leading plus. Only skip
+    // one that starts a number, so "+-5" stays an error.
+    auto const isNumberStart = [](char c) {
+        return std::isdigit(static_cast<unsigned char>(c)) != 0 || c == '.';
+    };
+    if (last - first > 1 && *first == '+' && isNumberStart(first[1])) { ++first; }
+
+    auto val          = 0.0;
+    auto const result = std::from_chars(first, last, val);
+    if (result.ec != std::errc{}) { return std::nullopt; }
+
+    // Same rule as parseSpiceNumber: the whole rest is the suffix, and an
+    // unknown suffix is ignored.
+    auto const suffix          = std::string_view{result.ptr, last};
+    auto const equalIgnoreCase = [](char l, char r) {
+        return std::toupper(static_cast<unsigned char>(l)) == r;
+    };
+    for (auto const& magnitude : magnitudes) {
+        if (std::ranges::equal(suffix, magnitude.suffix, equalIgnoreCase)) {
+            val *= magnitude.multiplier;
+            break;
+        }
+    }
+
+    // from_chars also takes "inf" and "nan", which are not SPICE values.
+    if (!std::isfinite(val)) { return std::nullopt; }
+    return val;
+}
+
 }  // namespace mc::detail
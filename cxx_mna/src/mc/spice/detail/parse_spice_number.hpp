@@ -1,9 +1,15 @@
 #pragma once
 
+#include <optional>
 #include <string>
+#include <string_view>
 
 namespace mc::detail {
 
 [[nodiscard]] auto parseSpiceNumber(std::string const& str) -> double;
 
+// Number with an optional magnitude suffix, e.g. "4.7k" or "10MEG", without
+// allocating. Returns std::nullopt if str does not start with a finite number.
+[[nodiscard]] auto tryParseSpiceNumber(std::string_view str) -> std::optional<double>;
+
 }  // namespace mc::detail
@@ -0,0 +1,266 @@
+#include "spice_netlist.hpp"
+
+#include <mc/spice/detail/parse_spice_number.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace mc {
+
+namespace {
+
+constexpr auto isBlank(char c) noexcept -> bool
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+auto trim(std::string_view str) -> std::string_view
+{
+    while (!str.empty() && isBlank(str.front())) { str.remove_prefix(1); }
+    while (!str.empty() && isBlank(str.back())) { str.remove_suffix(1); }
+    return str;
+}
+
+// Splits the next whitespace separated token off the front of str.
+auto nextToken(std::string_view& str) -> std::string_view
+{
+    auto first = std::size_t{0};
+    while (first < str.size() && isBlank(str[first])) { ++first; }
+    auto last = first;
+    while (last < str.size() && !isBlank(str[last])) { ++last; }
+
+    auto const token = str.substr(first, last - first);
+    str.remove_prefix(last);
+    return token;
+}
+
+// Removes and returns the first line of text, without the newline.
+auto nextLine(std::string_view& text) -> std::string_view
+{
+    auto const eol  = text.find('\n');
+    auto const line = text.substr(0, eol);
+    text.remove_prefix(eol == std::string_view::npos ? text.size() : eol + 1);
+    return line;
+}
+
+auto parseElement(std::string_view line, NameTable& nodes) -> SpiceNetlistElement
+{
+    auto rest           = line;
+    auto const name     = nextToken(rest);
+    auto const positive = nextToken(rest);
+    auto const negative = nextToken(rest);
+    auto const value    = detail::tryParseSpiceNumber(nextToken(rest));
+    if (negative.empty() || !value) {
+        throw std::runtime_error{fmt::format("invalid element: {}", line)};
+    }
+
+    return {line[0], name, nodes.intern(positive), nodes.intern(negative), *value};
+}
+
+// Returns true if text ends the netlist with .end.
+auto parseLines(std::string_view text,
+                NameTable& nodes,
+                std::vector<SpiceNetlistElement>& elements) -> bool
+{
+    while (!text.empty()) {
+        auto const line = trim(nextLine(text));
+        if (line == ".END" || line == ".end") { return true; }
+        if (line.empty()) { continue; }
+
+        switch (line[0]) {
+            case SpiceResistor::token:
+            case SpiceCapacitor::token:
+            case SpiceInductor::token:
+            case SpiceVoltageSource::token: {
+                elements.push_back(parseElement(line, nodes));
+                break;
+            }
+            default: {
+                break;
+            }
+        }
+    }
+    return false;
+}
+
+// Cuts text into about count pieces that each end after a newline.
+auto splitLines(std::string_view text, std::size_t count) -> std::vector<std::string_view>
+{
+    auto const target = text.size() / count + 1;
+
+    auto chunks = std::vector<std::string_view>{};
+    chunks.reserve(count);
+    while (!text.empty()) {
+        auto const eol = text.size() <= target ? text.npos : text.find('\n', target - 1);
+        auto const end = eol == text.npos ? text.size() : eol + 1;
+        chunks.push_back(text.substr(0, end));
+        text.remove_prefix(end);
+    }
+    return chunks;
+}
+
+struct Chunk
+{
+    std::string_view text;
+    NameTable nodes;
+    std::vector<SpiceNetlistElement> elements;
+    std::vector<NameTable::Id> toNetlist;  // chunk node id to netlist node id
+    std::size_t offset{0};                 // of the first element in the netlist
+    std::exception_ptr error;
+    bool ended{false};
+};
+
+auto parseChunk(Chunk& chunk) -> void
+{
+    try {
+        chunk.ended = parseLines(chunk.text, chunk.nodes, chunk.elements);
+    } catch (...) {
+        chunk.error = std::current_exception();
+    }
+}
+
+auto parseParallel(std::string_view text, std::size_t threads, SpiceNetlist& netlist)
+    -> void
+{
+    auto chunks = std::vector<Chunk>{};
+    for (auto const piece : splitLines(text, threads)) {
+        chunks.emplace_back().text = piece;
+    }
+
+    {
+        auto workers = std::vector<std::jthread>{};
+        for (auto i = std::size_t{1}; i < chunks.size(); ++i) {
+            workers.emplace_back(parseChunk, std::ref(chunks[i]));
+        }
+        parseChunk(chunks.front());
+    }
+
+    // Everything after .end is ignored, errors included. An earlier error
+    // is what the serial parse would have thrown.
+    auto const last = std::ranges::find_if(chunks, [](auto const& c) {
+        return c.error || c.ended;
+    });
+    auto const used = last == chunks.end() ? chunks.end() : std::next(last);
+    for (auto c = chunks.begin(); c != used; ++c) {
+        if (c->error) { std::rethrow_exception(c->error); }
+    }
+
+    // Interning in chunk order, each chunk's nodes in order of their first
+    // appearance in it, gives the ids of the serial parse.
+    auto size = std::size_t{0};
+    for (auto c = chunks.begin(); c != used; ++c) {
+        c->toNetlist.resize(c->nodes.size());
+        for (auto id = NameTable::Id{0}; id < c->nodes.size(); ++id) {
+            c->toNetlist[id] = netlist.nodes.intern(c->nodes.name(id));
+        }
+        c->offset = size;
+        size += c->elements.size();
+    }
+
+    netlist.elements.resize(size);
+    auto const renumber = [&netlist](Chunk const& chunk) {
+        auto out = netlist.elements.begin() + static_cast<std::ptrdiff_t>(chunk.offset);
+        for (auto e : chunk.elements) {
+            e.positive = chunk.toNetlist[e.positive];
+            e.negative = chunk.toNetlist[e.negative];
+            *out++     = e;
+        }
+    };
+
+    auto workers = std::vector<std::jthread>{};
+    for (auto c = std::next(chunks.begin()); c < used; ++c) {
+        workers.emplace_back(renumber, std::cref(*c));
+    }
+    renumber(chunks.front());
+}
+
+}  // namespace
+
+auto loadSpiceNetlist(std::filesystem::path const& path, SpiceNetlistOptions const& options)
+    -> SpiceNetlist
+{
+    auto netlist  = SpiceNetlist{};
+    netlist.file  = MappedFile{path};
+    auto text     = netlist.file.view();
+    netlist.title = nextLine(text);
+
+    auto const threads = options.threads == 0 ? std::thread::hardware_concurrency()
+                                              : options.threads;
+    auto const bySize  = text.size() / std::max<std::size_t>(options.minChunkSize, 1) + 1;
+    auto const chunks  = std::min<std::size_t>(std::max(threads, 1U), bySize);
+    if (chunks > 1) {
+        parseParallel(text, chunks, netlist);
+    } else {
+        parseLines(text, netlist.nodes, netlist.elements);
+    }
+    return netlist;
+}
+
+auto toSpiceCircuit(SpiceNetlist const& netlist) -> SpiceCircuit
+{
+    auto circuit  = SpiceCircuit{};
+    circuit.title = std::string{netlist.title};
+    circuit.elements.reserve(netlist.elements.size());
+
+    for (auto const& e : netlist.elements) {
+        auto name     = std::string{e.name};
+        auto positive = std::string{netlist.nodes.name(e.positive)};
+        auto negative = std::string{netlist.nodes.name(e.negative)};
+
+        switch (e.kind) {
+            case SpiceResistor::token: {
+                circuit.elements.push_back(SpiceResistor{
+                    .name     = std::move(name),
+                    .positive = std::move(positive),
+                    .negative = std::move(negative),
+                    .ohm      = e.value,
+                });
+                break;
+            }
+            case SpiceCapacitor::token: {
+                circuit.elements.push_back(SpiceCapacitor{
+                    .name     = std::move(name),
+                    .positive = std::move(positive),
+                    .negative = std::move(negative),
+                    .farad    = e.value,
+                });
+                break;
+            }
+            case SpiceInductor::token: {
+                circuit.elements.push_back(SpiceInductor{
+                    .name     = std::move(name),
+                    .positive = std::move(positive),
+                    .negative = std::move(negative),
+                    .henry    = e.value,
+                });
+                break;
+            }
+            case SpiceVoltageSource::token: {
+                circuit.elements.push_back(SpiceVoltageSource{
+                    .name     = std::move(name),
+                    .positive = std::move(positive),
+                    .negative = std::move(negative),
+                    .type     = SpiceVoltageSource::Type::dc,
+                    .voltage  = e.value,
+                });
+                break;
+            }
+            default: {
+                throw std::logic_error{fmt::format("unknown element kind: {}", e.kind)};
+            }
+        }
+    }
+
+    return circuit;
+}
+
+}  // namespace mc
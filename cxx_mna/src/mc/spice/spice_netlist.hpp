@@ -0,0 +1,59 @@
+#pragma once
+
+#include <mc/mapped_file.hpp>
+#include <mc/name_table.hpp>
+#include <mc/spice/spice_circuit.hpp>
+
+#include <cstddef>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+namespace mc {
+
+// One element line. The name points into the mapped file of its netlist.
+struct SpiceNetlistElement
+{
+    char kind;  // token of the element type, e.g. SpiceResistor::token
+    std::string_view name;
+    NameTable::Id positive;
+    NameTable::Id negative;
+    double value;  // ohm, farad, henry or volt
+};
+
+// The circuit of a netlist as the file says it, with node names interned
+// into ids in order of first appearance. Ground is a node like any other.
+struct SpiceNetlist
+{
+    MappedFile file;
+    std::string_view title;
+    NameTable nodes;
+    std::vector<SpiceNetlistElement> elements;
+};
+
+struct SpiceNetlistOptions
+{
+    // Threads that parse, including the calling one. 0 for one per core.
+    unsigned threads{1};
+
+    // Files are split into at most one chunk per this many bytes, so small
+    // files are parsed on the calling thread alone.
+    std::size_t minChunkSize{std::size_t{1} << 20U};
+};
+
+// Same rules as loadSpiceCircuit, but the file is memory mapped and split
+// into string_views, so the only allocations are for growing the element
+// vector and for new node names. Throws std::runtime_error on an element
+// line with a missing or invalid field.
+//
+// With more than one thread the file is cut into chunks at line boundaries
+// and each chunk is parsed into its own elements and node table. The chunks
+// are then merged in file order, so the result, including the node ids, is
+// the same as with one thread.
+[[nodiscard]] auto loadSpiceNetlist(std::filesystem::path const& path,
+                                    SpiceNetlistOptions const& options = {})
+    -> SpiceNetlist;
+
+[[nodiscard]] auto toSpiceCircuit(SpiceNetlist const& netlist) -> SpiceCircuit;
+
+}  // namespace mc
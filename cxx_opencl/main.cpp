@@ -1,61 +1,14 @@
+#include "benchmark.hpp"
+
 #include <CL/cl.hpp>
 
 #include <algorithm>
-#include <chrono>
 #include <iostream>
 #include <vector>
 
-#ifdef _MSC_VER
-
-#pragma optimize("", off)
-inline void DoNotOptimizeDependencySink(const void *) {}
-#pragma optimize("", on)
-
-/**
- * @brief Useful for writting benchmarks
- */
-template<class T>
-void DoNotOptimizeAway(const T &datum) {
-    DoNotOptimizeDependencySink(&datum);
-}
+int main(int argc, char **argv) {
+    auto bench = mc::Benchmark{argc, argv};
 
-#else
-
-/**
- * @brief Useful for writting benchmarks
- */
-template<typename T>
-auto DoNotOptimizeAway(const T &datum) -> void {
-    // This version of DoNotOptimizeAway tells the compiler that the asm
-    // block will read datum from memory, and that in addition it might read
-    // or write from any memory location.  If the memory clobber could be
-    // separated into input and output that would be preferable.
-    asm volatile("" ::"m"(datum)
-                 : "memory");
-}
-#endif
-
-/**
- * @brief Simple RAII timer. Prints the measured time to log info.
- */
-template<class Resolution = std::chrono::microseconds>
-class ExecutionTimer final {
-public:
-    using Clock = std::conditional_t<std::chrono::high_resolution_clock::is_steady, std::chrono::high_resolution_clock,
-                                     std::chrono::steady_clock>;
-
-public:
-    ExecutionTimer() = default;
-    ~ExecutionTimer() {
-        auto const micros = std::chrono::duration_cast<Resolution>(Clock::now() - mStart).count();
-        std::cout << "Elapsed: " << micros << "μs\n";
-    }
-
-private:
-    Clock::time_point mStart = Clock::now();
-};
-
-int main(int, char **) {
     auto all_platforms = std::vector<cl::Platform>{};
     cl::Platform::get(&all_platforms);
     if (all_platforms.size() == 0) {
@@ -97,6 +50,7 @@ int main(int, char **) {
 
     auto buffer = std::vector<float>{};
     buffer.resize(1 << 10, 0.5f);
+    auto output = std::vector<float>(buffer.size());
     //    std::cout << "Pre Buffer:\n";
     //    std::for_each(std::begin(buffer), std::end(buffer), [](auto const sample) {
     //        std::cout << " " << sample;
@@ -106,9 +60,21 @@ int main(int, char **) {
     auto kernel = cl::Kernel{program, "ProcessArray", &err};
     auto queue = cl::CommandQueue{context, device};
 
-    {
-        auto timer = ExecutionTimer{};
+    bench.Run("opencl: upload + kernel + read", [&] {
+        auto inputBuffer = cl::Buffer{context, CL_MEM_READ_ONLY | CL_MEM_HOST_NO_ACCESS | CL_MEM_COPY_HOST_PTR, sizeof(float) * buffer.size(), buffer.data()};
+        auto outputBuffer = cl::Buffer{context, CL_MEM_WRITE_ONLY | CL_MEM_HOST_READ_ONLY, sizeof(float) * buffer.size(), nullptr};
 
+        kernel.setArg(0, inputBuffer);
+        kernel.setArg(1, outputBuffer);
+        kernel.setArg(2, 0.75f);
+
+        queue.enqueueNDRangeKernel(kernel, cl::NullRange, cl::NDRange{buffer.size()});
+        queue.enqueueTask(kernel);
+        queue.enqueueReadBuffer(outputBuffer, CL_TRUE, 0, sizeof(float) * output.size(), output.data());
+        mc::DoNotOptimizeAway(output.data());
+    });
+
+    {
         auto inputBuffer = cl::Buffer{context, CL_MEM_READ_ONLY | CL_MEM_HOST_NO_ACCESS | CL_MEM_COPY_HOST_PTR, sizeof(float) * buffer.size(), buffer.data()};
         auto outputBuffer = cl::Buffer{context, CL_MEM_WRITE_ONLY | CL_MEM_HOST_READ_ONLY, sizeof(float) * buffer.size(), nullptr};
 
@@ -116,31 +82,29 @@ int main(int, char **) {
         kernel.setArg(1, outputBuffer);
         kernel.setArg(2, 0.75f);
 
-        {
-            auto timer2 = ExecutionTimer{};
+        bench.Run("opencl: kernel + read", [&] {
             queue.enqueueNDRangeKernel(kernel, cl::NullRange, cl::NDRange{buffer.size()});
             queue.enqueueTask(kernel);
-            queue.enqueueReadBuffer(outputBuffer, CL_TRUE, 0, sizeof(float) * buffer.size(), buffer.data());
-            DoNotOptimizeAway(outputBuffer);
-        }
-    }
-    {
-        auto timer3 = ExecutionTimer{};
-        for (auto x = 0; x < 100; x++) {
-            std::transform(std::begin(buffer), std::end(buffer), std::begin(buffer), [](auto const sample) -> float {
-                return sample * 0.75;
-            });
-
-            DoNotOptimizeAway(buffer);
-            DoNotOptimizeAway(x);
-        }
+            queue.enqueueReadBuffer(outputBuffer, CL_TRUE, 0, sizeof(float) * output.size(), output.data());
+            mc::DoNotOptimizeAway(output.data());
+        });
     }
 
+    // Reads buffer and writes output like the kernel, so repeated runs do
+    // not drift into denormals.
+    bench.Run("cpu: transform", [&] {
+        std::transform(std::begin(buffer), std::end(buffer), std::begin(output), [](auto const sample) -> float {
+            return sample * 0.75f;
+        });
+        mc::DoNotOptimizeAway(output.data());
+        mc::ClobberMemory();
+    });
+
 //    std::cout << "Post Buffer:\n";
 //    std::for_each(std::begin(buffer), std::end(buffer), [](auto const sample) {
 //        std::cout << " " << sample;
 //    });
 //    std::cout << "\n";
 
-    return EXIT_SUCCESS;
+    return bench.Finish();
 }
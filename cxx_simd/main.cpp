@@ -4,9 +4,12 @@
 
 auto print(char const* prefix, simd::Reg256f reg) -> void
 {
-    std::printf("%15s: %2.0f", prefix, reg.m256_f32[0]);
+    float values[8];
+    simd::storeTo(values, reg);
+
+    std::printf("%15s: %2.0f", prefix, values[0]);
     for (std::size_t i = 1; i < 8; ++i) {
-        std::printf(", %2.0f", reg.m256_f32[i]);
+        std::printf(", %2.0f", values[i]);
     }
     std::printf("\n");
 }
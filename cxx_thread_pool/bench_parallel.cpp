@@ -0,0 +1,86 @@
+#include "benchmark.hpp"
+#include "parallel.hpp"
+
+#if defined(MC_HAVE_TBB)
+    #include <tbb/blocked_range.h>
+    #include <tbb/parallel_for.h>
+    #include <tbb/parallel_reduce.h>
+#endif
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include <numeric>
+#include <ranges>
+#include <vector>
+
+namespace
+{
+
+constexpr auto Tasks = std::size_t {1000};
+
+// Same shape as the tasks in cxx_intel_tbb/main.cpp: deliberately slow.
+auto Spin(std::size_t n) -> void
+{
+    for (auto i = 0; i < 100'000; ++i)
+    {
+        mc::DoNotOptimizeAway(i);
+    }
+    mc::DoNotOptimizeAway(n);
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    auto const values = std::vector<double>(1 << 24, 2.0);
+    auto bench        = mc::Benchmark {argc, argv};
+
+    bench.Run("for: serial", [] {
+        for (std::size_t i = 0; i < Tasks; ++i)
+        {
+            Spin(i);
+        }
+    });
+
+    bench.Run("for: mc::parallel_for", [] { mc::parallel_for(std::views::iota(std::size_t {0}, Tasks), Spin); });
+
+#if defined(MC_HAVE_TBB)
+    bench.Run("for: tbb::parallel_for", [] {
+        tbb::parallel_for(tbb::blocked_range<std::size_t>(0, Tasks), [](tbb::blocked_range<std::size_t> const& r) {
+            for (auto i = r.begin(); i < r.end(); ++i)
+            {
+                Spin(i);
+            }
+        });
+    });
+#endif
+
+    auto const sqrtPlus = [](double acc, double v) { return acc + std::sqrt(v); };
+
+    bench.Run("reduce: serial",
+              [&] { mc::DoNotOptimizeAway(std::accumulate(values.begin(), values.end(), 0.0, sqrtPlus)); });
+
+    bench.Run("reduce: mc::parallel_reduce", [&] {
+        auto const leafSqrt = std::views::transform(values, [](double v) { return std::sqrt(v); });
+        mc::DoNotOptimizeAway(mc::parallel_reduce(leafSqrt, 0.0));
+    });
+
+#if defined(MC_HAVE_TBB)
+    bench.Run("reduce: tbb::parallel_reduce", [&] {
+        mc::DoNotOptimizeAway(tbb::parallel_reduce(
+            tbb::blocked_range<std::size_t>(0, values.size()), 0.0,
+            [&values, &sqrtPlus](tbb::blocked_range<std::size_t> const& r, double acc) {
+                for (auto i = r.begin(); i < r.end(); ++i)
+                {
+                    acc = sqrtPlus(acc, values[i]);
+                }
+                return acc;
+            },
+            std::plus<> {}));
+    });
+#endif
+
+    return bench.Finish();
+}
@@ -0,0 +1,295 @@
+#include "benchmark.hpp"
+#include "parallel.hpp"
+#include "pool.hpp"
+
+#if defined(MC_HAVE_TBB)
+    #include <tbb/parallel_pipeline.h>
+    #include <tbb/task_arena.h>
+#endif
+
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <atomic>
+#include <semaphore>
+#include <vector>
+
+// The read -> transform -> write pipeline from cxx_intel_tbb/pipeline.cpp,
+// on an in-memory input, once with tbb::parallel_pipeline and once on
+// mc::ThreadPool. Both use the same number of threads and tokens.
+
+namespace
+{
+
+constexpr auto BlockSize = std::size_t {64 * 1024};
+
+struct Block
+{
+    std::vector<char> bytes = std::vector<char>(BlockSize);
+    std::size_t size {0};
+    std::uint64_t hash {0};
+};
+
+// Input and output of one run. The checksum folds the block hashes in write
+// order, so it only matches the serial run if blocks are written in order.
+struct Stream
+{
+    std::vector<char> const* input;
+    std::vector<char> output;
+    std::size_t readPos {0};
+    std::size_t writePos {0};
+    std::uint64_t checksum {0};
+
+    explicit Stream(std::vector<char> const& in) : input {&in}, output(in.size()) { }
+
+    // Rewinds for the next run, keeping the output buffer.
+    auto Reset() -> void
+    {
+        readPos  = 0;
+        writePos = 0;
+        checksum = 0;
+    }
+
+    auto Read(Block& block) -> bool
+    {
+        block.size = std::min(BlockSize, input->size() - readPos);
+        std::memcpy(block.bytes.data(), input->data() + readPos, block.size);
+        readPos += block.size;
+        return block.size != 0;
+    }
+
+    auto Write(Block const& block) -> void
+    {
+        std::memcpy(output.data() + writePos, block.bytes.data(), block.size);
+        writePos += block.size;
+        checksum = checksum * 31 + block.hash;
+    }
+};
+
+// Upper-case and FNV-1a, a few cycles per byte.
+auto Transform(Block& block) -> void
+{
+    auto hash = std::uint64_t {14695981039346656037ULL};
+    for (std::size_t i = 0; i < block.size; ++i)
+    {
+        auto const c   = static_cast<char>(std::toupper(static_cast<unsigned char>(block.bytes[i])));
+        block.bytes[i] = c;
+        hash           = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+    }
+    block.hash = hash;
+}
+
+auto Serial(Stream& stream) -> void
+{
+    auto block = Block {};
+    while (stream.Read(block))
+    {
+        Transform(block);
+        stream.Write(block);
+    }
+}
+
+// Ordered pipeline on the pool: the calling thread reads, the pool
+// transforms, and whichever worker finishes the next block in sequence
+// writes it and every following block that is already done. A semaphore
+// holds the number of blocks in flight to the token count; while the reader
+// waits for a token it runs queued transforms itself.
+class PoolPipeline
+{
+public:
+    PoolPipeline(mc::ThreadPool& pool, std::size_t tokens)
+        : pool_ {pool}, slots_(tokens), free_ {static_cast<std::ptrdiff_t>(tokens)}, group_ {pool}
+    {
+    }
+
+    auto Run(Stream& stream) -> void
+    {
+        // The previous run, if any, has finished writing.
+        next_.store(0, std::memory_order_relaxed);
+
+        for (std::size_t seq = 0;; ++seq)
+        {
+            acquire();
+            auto& slot = slots_[seq % slots_.size()];
+            if (!stream.Read(slot.block))
+            {
+                free_.release();
+                break;
+            }
+
+            group_.Run([this, &slot, &stream] {
+                Transform(slot.block);
+                slot.ready.store(true, std::memory_order_release);
+                drain(stream);
+            });
+        }
+
+        // The writer may still be inside drain() after returning the last
+        // token, so wait for the tasks rather than the tokens.
+        group_.Wait();
+    }
+
+private:
+    struct Slot
+    {
+        Block block;
+        std::atomic<bool> ready {false};
+    };
+
+    auto acquire() -> void
+    {
+        while (!free_.try_acquire())
+        {
+            if (!pool_.TryRunPendingTask())
+            {
+                free_.acquire();
+                return;
+            }
+        }
+    }
+
+    auto drain(Stream& stream) -> void
+    {
+        // Every ready block adds a request. Whoever moves the count off zero
+        // writes, and keeps going until it takes the count back to zero, so a
+        // block that became ready during a pass is picked up by the next one.
+        if (requests_.fetch_add(1, std::memory_order_acq_rel) != 0)
+        {
+            return;
+        }
+
+        auto seen = std::size_t {1};
+        for (;;)
+        {
+            auto next = next_.load(std::memory_order_relaxed);
+            for (;; ++next)
+            {
+                auto& slot = slots_[next % slots_.size()];
+                if (!slot.ready.load(std::memory_order_acquire))
+                {
+                    break;
+                }
+
+                stream.Write(slot.block);
+                slot.ready.store(false, std::memory_order_relaxed);
+                free_.release();
+            }
+            next_.store(next, std::memory_order_relaxed);
+
+            auto const left = requests_.fetch_sub(seen, std::memory_order_acq_rel) - seen;
+            if (left == 0)
+            {
+                return;
+            }
+            seen = left;
+        }
+    }
+
+    mc::ThreadPool& pool_;
+    std::vector<Slot> slots_;
+    std::counting_semaphore<> free_;
+    std::atomic<std::size_t> requests_ {0};
+    std::atomic<std::size_t> next_ {0};
+    mc::TaskGroup group_;
+};
+
+#if defined(MC_HAVE_TBB)
+auto Tbb(Stream& stream, int threads, std::size_t tokens) -> void
+{
+    auto blocks = std::vector<Block>(tokens);
+    auto next   = std::size_t {0};
+
+    auto read = [&](tbb::flow_control& fc) -> Block* {
+        auto& block = blocks[next++ % tokens];
+        if (!stream.Read(block))
+        {
+            fc.stop();
+            return nullptr;
+        }
+        return &block;
+    };
+
+    auto transform = [](Block* block) -> Block* {
+        Transform(*block);
+        return block;
+    };
+
+    auto write = [&stream](Block* block) { stream.Write(*block); };
+
+    auto arena = tbb::task_arena {threads};
+    arena.execute([&] {
+        tbb::parallel_pipeline(tokens, tbb::make_filter<void, Block*>(tbb::filter_mode::serial_in_order, read)
+                                           & tbb::make_filter<Block*, Block*>(tbb::filter_mode::parallel, transform)
+                                           & tbb::make_filter<Block*, void>(tbb::filter_mode::serial_in_order, write));
+    });
+}
+#endif
+
+auto Check(char const* name, Stream const& stream, Stream const& reference) -> void
+{
+    if (stream.checksum != reference.checksum || stream.output != reference.output)
+    {
+        std::printf("%s: output differs from the serial run\n", name);
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+}  // namespace
+
+// usage: bench_pipeline [megabytes] [benchmark options]
+int main(int argc, char** argv)
+{
+    auto const megabytes = argc > 1 && argv[1][0] != '-' ? std::atoi(argv[1]) : 64;
+    auto input           = std::vector<char>(static_cast<std::size_t>(megabytes) << 20U);
+    for (std::size_t i = 0; i < input.size(); ++i)
+    {
+        input[i] = static_cast<char>('a' + (i * 7 + i / 13) % 26);
+    }
+
+    auto& pool        = mc::ThreadPool::GlobalInstance();
+    auto const tokens = pool.Size() * 4;
+    auto bench        = mc::Benchmark {argc, argv};
+
+    auto serial = Stream {input};
+    bench.Run("pipeline: serial", [&] {
+        serial.Reset();
+        Serial(serial);
+    });
+
+    auto onPool = Stream {input};
+    {
+        auto pipeline = PoolPipeline {pool, tokens};
+        bench.Run("pipeline: mc::ThreadPool", [&] {
+            onPool.Reset();
+            pipeline.Run(onPool);
+        });
+    }
+
+#if defined(MC_HAVE_TBB)
+    auto onTbb = Stream {input};
+    bench.Run("pipeline: tbb::parallel_pipeline", [&] {
+        onTbb.Reset();
+        Tbb(onTbb, static_cast<int>(pool.Size()), tokens);
+    });
+#endif
+
+    // A run that was filtered out never touched its output.
+    if (serial.writePos == input.size())
+    {
+        if (onPool.writePos != 0)
+        {
+            Check("mc::ThreadPool", onPool, serial);
+        }
+#if defined(MC_HAVE_TBB)
+        if (onTbb.writePos != 0)
+        {
+            Check("tbb::parallel_pipeline", onTbb, serial);
+        }
+#endif
+    }
+
+    return bench.Finish();
+}
@@ -0,0 +1,98 @@
+#include "pool.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <new>
+#include <vector>
+
+namespace
+{
+std::atomic<std::size_t> allocations {0};
+}  // namespace
+
+auto operator new(std::size_t size) -> void*
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto* ptr = std::malloc(size == 0 ? 1 : size); ptr != nullptr)
+    {
+        return ptr;
+    }
+    throw std::bad_alloc {};
+}
+
+auto operator delete(void* ptr) noexcept -> void { std::free(ptr); }
+auto operator delete(void* ptr, std::size_t /*size*/) noexcept -> void { std::free(ptr); }
+
+namespace
+{
+
+// What mc::Async did before: a heap packaged_task behind a std::function.
+template<typename Function>
+auto LegacyAsync(Function f)
+{
+    using result_type   = std::invoke_result_t<Function>;
+    using packaged_type = std::packaged_task<result_type()>;
+
+    auto* package = new packaged_type(std::move(f));
+    auto result   = package->get_future();
+    auto job      = std::function<void()> {[package] {
+        (*package)();
+        delete package;
+    }};
+    mc::ThreadPool::GlobalInstance().Async([job = std::move(job)] { job(); });
+    return result;
+}
+
+template<typename Future, typename Submit>
+auto Measure(char const* name, Submit submit) -> void
+{
+    constexpr auto batch   = 256;
+    constexpr auto batches = 400;
+
+    auto futures = std::vector<Future> {};
+    futures.reserve(batch);
+
+    auto const round = [&] {
+        auto sum = 0;
+        for (auto b = 0; b < batches; ++b)
+        {
+            for (auto i = 0; i < batch; ++i)
+            {
+                futures.push_back(submit(i));
+            }
+            for (auto& f : futures)
+            {
+                sum += f.get();
+            }
+            futures.clear();
+        }
+        return sum;
+    };
+
+    // Warm up the pool, slabs and ring buffers.
+    static_cast<void>(round());
+
+    auto const allocsBefore = allocations.load();
+    auto const start        = std::chrono::steady_clock::now();
+    auto const sum          = round();
+    auto const stop         = std::chrono::steady_clock::now();
+    auto const allocs       = allocations.load() - allocsBefore;
+
+    auto const tasks = static_cast<double>(batch * batches);
+    auto const ns    = std::chrono::duration<double, std::nano>(stop - start).count();
+    std::printf("%-28s %8.2f allocs/task %10.1f ns/task (checksum %d)\n", name, static_cast<double>(allocs) / tasks,
+                ns / tasks, sum);
+}
+
+}  // namespace
+
+int main(int, char**)
+{
+    Measure<std::future<int>>("packaged_task+std::function", [](int i) { return LegacyAsync([i] { return i; }); });
+    Measure<mc::Future<int>>("mc::Task+mc::Future", [](int i) { return mc::Async([i] { return i; }); });
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,80 @@
+#include "benchmark.hpp"
+#include "trace.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+// Cost of one MC_TRACE_SCOPE with tracing off and on. Scopes are recorded
+// in bursts that fit into the ring, with pauses for the flusher, so the
+// enabled numbers are for events that are actually kept.
+
+namespace
+{
+
+constexpr auto Burst  = 4096;
+constexpr auto Bursts = 64;
+
+auto Scopes() -> void
+{
+    for (auto i = 0; i < Burst; ++i)
+    {
+        MC_TRACE_SCOPE("bench");
+        mc::DoNotOptimizeAway(i);
+    }
+}
+
+auto Measure(char const* name, std::chrono::milliseconds pause) -> void
+{
+    auto ns = std::vector<double> {};
+    for (auto b = 0; b < Bursts; ++b)
+    {
+        auto const start = mc::TraceClock::Now();
+        Scopes();
+        auto const stop = mc::TraceClock::Now();
+        ns.push_back(mc::TraceClock::ToNanoseconds(stop - start) / Burst);
+        std::this_thread::sleep_for(pause);
+    }
+
+    std::sort(ns.begin(), ns.end());
+    std::printf("%-22s median %6.2f ns/scope  min %6.2f ns/scope\n", name, ns[ns.size() / 2], ns.front());
+}
+
+// Every enabled scope reads the clock twice. Under virtualization rdtsc can
+// be a lot slower than on bare metal, so print it for reference.
+auto ClockCost() -> void
+{
+    auto sum         = std::uint64_t {0};
+    auto const start = mc::TraceClock::Now();
+    for (auto i = 0; i < Burst * Bursts; ++i)
+    {
+        sum += mc::TraceClock::Now();
+    }
+    auto const stop = mc::TraceClock::Now();
+    mc::DoNotOptimizeAway(sum);
+
+    auto const ns = mc::TraceClock::ToNanoseconds(stop - start) / (Burst * Bursts);
+    std::printf("%-22s        %6.2f ns/read\n", "TraceClock::Now", ns);
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    auto const* path = argc > 1 ? argv[1] : "bench_trace.json";
+
+    ClockCost();
+    Measure("tracing off", std::chrono::milliseconds {0});
+    {
+        auto const session = mc::TraceSession {path};
+        Measure("tracing on", std::chrono::milliseconds {30});
+    }
+    std::printf("trace written to %s\n", path);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace mc
+{
+
+/**
+ * @brief Lets idle workers park without missing a wakeup.
+ *
+ * A waiter calls PrepareWait(), re-checks its condition and then either
+ * CancelWait() or CommitWait(key). A notifier publishes work first and then
+ * calls NotifyOne/NotifyAll. Blocking goes through std::atomic::wait, which is
+ * a futex on Linux. Notifiers only touch the shared epoch when somebody waits.
+ */
+class EventCount
+{
+public:
+    using Key = std::uint32_t;
+
+    [[nodiscard]] auto PrepareWait() noexcept -> Key
+    {
+        waiters_.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return epoch_.load(std::memory_order_acquire);
+    }
+
+    auto CancelWait() noexcept -> void { waiters_.fetch_sub(1, std::memory_order_relaxed); }
+
+    auto CommitWait(Key key) noexcept -> void
+    {
+        epoch_.wait(key, std::memory_order_acquire);
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    auto NotifyOne() noexcept -> void
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_relaxed) != 0)
+        {
+            epoch_.fetch_add(1, std::memory_order_release);
+            epoch_.notify_one();
+        }
+    }
+
+    auto NotifyAll() noexcept -> void
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_relaxed) != 0)
+        {
+            epoch_.fetch_add(1, std::memory_order_release);
+            epoch_.notify_all();
+        }
+    }
+
+private:
+    alignas(64) std::atomic<std::uint32_t> waiters_ {0};
+    alignas(64) std::atomic<std::uint32_t> epoch_ {0};
+};
+
+}  // namespace mc
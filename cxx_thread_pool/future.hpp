@@ -0,0 +1,628 @@
+#pragma once
+
+#include "slab.hpp"
+#include "task.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace mc
+{
+
+template<typename T>
+class Future;
+
+template<typename T>
+class Promise;
+
+namespace detail
+{
+
+struct Unit
+{
+};
+
+template<typename T>
+using Stored = std::conditional_t<std::is_void_v<T>, Unit, T>;
+
+/// Hands a continuation to the global ThreadPool. Defined in pool.cpp.
+auto ScheduleContinuation(Task&& task) -> void;
+
+/**
+ * @brief Callback attached to a SharedState, run once the value is set.
+ *
+ * Inline continuations run on the publishing thread and must be cheap,
+ * they are only used for the bookkeeping of then, when_all and when_any.
+ * Everything else is scheduled on the pool.
+ */
+struct Continuation
+{
+    static auto operator new(std::size_t size) -> void* { return SlabAllocate(size); }
+    static auto operator delete(void* ptr, std::size_t size) noexcept -> void { SlabDeallocate(ptr, size); }
+
+    Task task;
+    bool inlined {false};
+    Continuation* next {nullptr};
+};
+
+// Marks a list that has already been run. Attaching to it runs immediately.
+inline Continuation closedContinuations {};
+
+inline auto RunContinuations(Continuation* list) noexcept -> void
+{
+    // Attached LIFO, run in attach order.
+    Continuation* reversed = nullptr;
+    while (list != nullptr)
+    {
+        reversed = std::exchange(list, std::exchange(list->next, reversed));
+    }
+
+    while (reversed != nullptr)
+    {
+        auto* c = std::exchange(reversed, reversed->next);
+        if (c->inlined)
+        {
+            c->task();
+        }
+        else
+        {
+            ScheduleContinuation(std::move(c->task));
+        }
+        delete c;
+    }
+}
+
+inline auto AttachContinuation(std::atomic<Continuation*>& list, Continuation* c) noexcept -> void
+{
+    auto* head = list.load(std::memory_order_acquire);
+    do
+    {
+        if (head == &closedContinuations)
+        {
+            c->next = nullptr;
+            RunContinuations(c);
+            return;
+        }
+
+        c->next = head;
+    } while (!list.compare_exchange_weak(head, c, std::memory_order_acq_rel, std::memory_order_acquire));
+}
+
+/**
+ * @brief Shared state between one Promise and one Future.
+ *
+ * Allocated from the per-thread slab and reference counted by its two
+ * owners, so the common path never touches malloc.
+ */
+template<typename T>
+struct SharedState
+{
+    static auto operator new(std::size_t size) -> void* { return SlabAllocate(size); }
+    static auto operator delete(void* ptr, std::size_t size) noexcept -> void { SlabDeallocate(ptr, size); }
+
+    auto Release() noexcept -> void
+    {
+        if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            delete this;
+        }
+    }
+
+    auto Publish() noexcept -> void
+    {
+        ready.store(1, std::memory_order_release);
+        ready.notify_all();
+        RunContinuations(continuations.exchange(&closedContinuations, std::memory_order_acq_rel));
+    }
+
+    auto Wait() const noexcept -> void { ready.wait(0, std::memory_order_acquire); }
+
+    [[nodiscard]] auto IsReady() const noexcept -> bool { return ready.load(std::memory_order_acquire) != 0; }
+
+    std::atomic<std::uint32_t> refs {2};
+    std::atomic<std::uint32_t> ready {0};
+    std::atomic<Continuation*> continuations {nullptr};
+    std::optional<Stored<T>> value;
+    std::exception_ptr exception;
+};
+
+template<typename R>
+struct Unwrap
+{
+    using type = R;
+};
+
+template<typename U>
+struct Unwrap<Future<U>>
+{
+    using type = U;
+};
+
+template<typename T, typename Func>
+auto ContinuationResultOf()
+{
+    if constexpr (std::is_invocable_v<Func&, Future<T>>)
+    {
+        return std::type_identity<std::invoke_result_t<Func&, Future<T>>> {};
+    }
+    else if constexpr (std::is_void_v<T>)
+    {
+        return std::type_identity<std::invoke_result_t<Func&>> {};
+    }
+    else
+    {
+        return std::type_identity<std::invoke_result_t<Func&, T>> {};
+    }
+}
+
+template<typename T, typename Func>
+using ContinuationResult = typename decltype(ContinuationResultOf<T, Func>())::type;
+
+struct FutureAccess;
+
+}  // namespace detail
+
+/**
+ * @brief Single-shot future with the std::future interface, plus then()
+ * from the Concurrency TS.
+ */
+template<typename T>
+class Future
+{
+public:
+    using value_type = T;
+
+    Future() noexcept = default;
+
+    Future(Future const&) = delete;
+    Future(Future&& other) noexcept : state_ {std::exchange(other.state_, nullptr)} { }
+
+    auto operator=(Future const&) -> Future& = delete;
+    auto operator=(Future&& other) noexcept -> Future&
+    {
+        std::swap(state_, other.state_);
+        return *this;
+    }
+
+    ~Future() noexcept
+    {
+        if (state_ != nullptr)
+        {
+            state_->Release();
+        }
+    }
+
+    [[nodiscard]] auto valid() const noexcept -> bool { return state_ != nullptr; }
+
+    [[nodiscard]] auto is_ready() const noexcept -> bool { return state_ != nullptr && state_->IsReady(); }
+
+    auto wait() const -> void
+    {
+        assert(valid());
+        state_->Wait();
+    }
+
+    auto get() -> T
+    {
+        wait();
+        auto* state        = std::exchange(state_, nullptr);
+        auto const release = ReleaseGuard {state};
+
+        if (state->exception)
+        {
+            std::rethrow_exception(state->exception);
+        }
+
+        if constexpr (!std::is_void_v<T>)
+        {
+            return std::move(*state->value);
+        }
+    }
+
+    /**
+     * @brief Runs func on the pool once this future is ready, without
+     * blocking a thread in the meantime. Consumes this future.
+     *
+     * A func that takes Future<T> gets the ready future. Otherwise it gets
+     * the value, and an exception skips func and goes straight to the
+     * returned future. A func returning Future<U> is unwrapped to Future<U>.
+     */
+    template<typename Func>
+    auto then(Func&& func) -> Future<typename detail::Unwrap<detail::ContinuationResult<T, std::decay_t<Func>>>::type>;
+
+private:
+    friend class Promise<T>;
+    friend struct detail::FutureAccess;
+
+    struct ReleaseGuard
+    {
+        explicit ReleaseGuard(detail::SharedState<T>* s) noexcept : state {s} { }
+        ReleaseGuard(ReleaseGuard const&)                    = delete;
+        auto operator=(ReleaseGuard const&) -> ReleaseGuard& = delete;
+        ~ReleaseGuard() { state->Release(); }
+        detail::SharedState<T>* state;
+    };
+
+    explicit Future(detail::SharedState<T>* state) noexcept : state_ {state} { }
+
+    detail::SharedState<T>* state_ {nullptr};
+};
+
+template<typename T>
+class Promise
+{
+public:
+    Promise() : state_ {new detail::SharedState<T> {}} { }
+
+    Promise(Promise const&) = delete;
+    Promise(Promise&& other) noexcept
+        : state_ {std::exchange(other.state_, nullptr)}, retrieved_ {std::exchange(other.retrieved_, false)}
+    {
+    }
+
+    auto operator=(Promise const&) -> Promise& = delete;
+    auto operator=(Promise&& other) noexcept -> Promise&
+    {
+        std::swap(state_, other.state_);
+        std::swap(retrieved_, other.retrieved_);
+        return *this;
+    }
+
+    ~Promise() noexcept
+    {
+        if (state_ == nullptr)
+        {
+            return;
+        }
+
+        if (!state_->IsReady())
+        {
+            state_->exception = std::make_exception_ptr(std::future_error {std::future_errc::broken_promise});
+            state_->Publish();
+        }
+
+        // Nobody will ever ask for the future, drop its reference as well.
+        if (!retrieved_)
+        {
+            state_->Release();
+        }
+        state_->Release();
+    }
+
+    [[nodiscard]] auto get_future() -> Future<T>
+    {
+        assert(state_ != nullptr && !retrieved_);
+        retrieved_ = true;
+        return Future<T> {state_};
+    }
+
+    template<typename... Values>
+    auto set_value(Values&&... values) -> void
+    {
+        state_->value.emplace(std::forward<Values>(values)...);
+        state_->Publish();
+    }
+
+    auto set_exception(std::exception_ptr e) -> void
+    {
+        state_->exception = std::move(e);
+        state_->Publish();
+    }
+
+private:
+    detail::SharedState<T>* state_;
+    bool retrieved_ {false};
+};
+
+namespace detail
+{
+template<typename T, typename Func, typename... Args>
+auto SetPromiseWith(Promise<T>& promise, Func& func, Args&... args) -> void
+{
+    try
+    {
+        if constexpr (std::is_void_v<T>)
+        {
+            std::invoke(func, std::move(args)...);
+            promise.set_value();
+        }
+        else
+        {
+            promise.set_value(std::invoke(func, std::move(args)...));
+        }
+    }
+    catch (...)
+    {
+        promise.set_exception(std::current_exception());
+    }
+}
+
+struct FutureAccess
+{
+    template<typename T>
+    static auto State(Future<T> const& future) noexcept -> SharedState<T>*
+    {
+        return future.state_;
+    }
+};
+
+template<typename T, typename Func>
+auto OnReady(SharedState<T>* state, bool inlined, Func&& func) -> void
+{
+    assert(state != nullptr);
+    AttachContinuation(state->continuations, new Continuation {Task {std::forward<Func>(func)}, inlined});
+}
+
+template<typename T, typename Func>
+auto OnReady(Future<T> const& future, bool inlined, Func&& func) -> void
+{
+    OnReady(FutureAccess::State(future), inlined, std::forward<Func>(func));
+}
+
+template<typename T>
+inline constexpr bool isFuture = false;
+
+template<typename T>
+inline constexpr bool isFuture<Future<T>> = true;
+
+// Completes promise with whatever inner ends up with.
+template<typename U>
+auto Forward(Future<U> inner, Promise<U> promise) -> void
+{
+    if (!inner.valid())
+    {
+        promise.set_exception(std::make_exception_ptr(std::future_error {std::future_errc::broken_promise}));
+        return;
+    }
+
+    auto* state = FutureAccess::State(inner);
+    OnReady(state, true, [inner = std::move(inner), p = std::move(promise)]() mutable {
+        auto get = [&inner] { return inner.get(); };
+        SetPromiseWith(p, get);
+    });
+}
+
+template<typename T, typename U, typename Func>
+auto RunContinuation(Future<T> self, Promise<U> promise, Func& func) -> void
+{
+    using result_type = ContinuationResult<T, Func>;
+
+    auto call = [&]() -> result_type {
+        if constexpr (std::is_invocable_v<Func&, Future<T>>)
+        {
+            return std::invoke(func, std::move(self));
+        }
+        else if constexpr (std::is_void_v<T>)
+        {
+            self.get();
+            return std::invoke(func);
+        }
+        else
+        {
+            return std::invoke(func, self.get());
+        }
+    };
+
+    if constexpr (isFuture<result_type>)
+    {
+        auto inner = result_type {};
+        try
+        {
+            inner = call();
+        }
+        catch (...)
+        {
+            promise.set_exception(std::current_exception());
+            return;
+        }
+        Forward(std::move(inner), std::move(promise));
+    }
+    else
+    {
+        SetPromiseWith(promise, call);
+    }
+}
+
+}  // namespace detail
+
+template<typename T>
+template<typename Func>
+auto Future<T>::then(Func&& func)
+    -> Future<typename detail::Unwrap<detail::ContinuationResult<T, std::decay_t<Func>>>::type>
+{
+    using result_type = typename detail::Unwrap<detail::ContinuationResult<T, std::decay_t<Func>>>::type;
+
+    assert(valid());
+    auto promise = Promise<result_type> {};
+    auto result  = promise.get_future();
+    auto* state  = std::exchange(state_, nullptr);
+
+    detail::OnReady(
+        state, false, [self = Future {state}, p = std::move(promise), f = std::forward<Func>(func)]() mutable {
+            detail::RunContinuation(std::move(self), std::move(p), f);
+        });
+
+    return result;
+}
+
+/**
+ * @brief Result of when_any: the futures, and the index of one that is ready.
+ */
+template<typename Sequence>
+struct when_any_result
+{
+    std::size_t index;
+    Sequence futures;
+};
+
+/**
+ * @brief Future that becomes ready once all futures in the range are ready.
+ * The futures are moved into the result, none of them is consumed.
+ */
+template<std::input_iterator InputIt>
+auto when_all(InputIt first, InputIt last) -> Future<std::vector<std::iter_value_t<InputIt>>>
+{
+    using Sequence = std::vector<std::iter_value_t<InputIt>>;
+
+    struct Context
+    {
+        Sequence futures;
+        std::atomic<std::size_t> remaining {0};
+        Promise<Sequence> promise;
+    };
+
+    auto ctx = std::make_shared<Context>();
+    ctx->futures.assign(std::make_move_iterator(first), std::make_move_iterator(last));
+    auto result = ctx->promise.get_future();
+
+    // One extra count for ourselves, so nothing completes while we attach.
+    ctx->remaining.store(ctx->futures.size() + 1, std::memory_order_relaxed);
+    auto const arrive = [](Context& c) {
+        if (c.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            c.promise.set_value(std::move(c.futures));
+        }
+    };
+
+    for (auto const& future : ctx->futures)
+    {
+        detail::OnReady(future, true, [ctx, arrive] { arrive(*ctx); });
+    }
+
+    arrive(*ctx);
+    return result;
+}
+
+template<typename... Ts>
+auto when_all(Future<Ts>&&... futures) -> Future<std::tuple<Future<Ts>...>>
+{
+    using Sequence = std::tuple<Future<Ts>...>;
+
+    struct Context
+    {
+        Sequence futures;
+        std::atomic<std::size_t> remaining {sizeof...(Ts) + 1};
+        Promise<Sequence> promise;
+    };
+
+    auto ctx    = std::make_shared<Context>(Sequence {std::move(futures)...});
+    auto result = ctx->promise.get_future();
+
+    auto const arrive = [](Context& c) {
+        if (c.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            c.promise.set_value(std::move(c.futures));
+        }
+    };
+
+    std::apply([&](auto const&... f) { (detail::OnReady(f, true, [ctx, arrive] { arrive(*ctx); }), ...); },
+               ctx->futures);
+
+    arrive(*ctx);
+    return result;
+}
+
+/**
+ * @brief Future that becomes ready once any future in the range is ready.
+ * An empty range is ready at once, with index -1.
+ */
+template<std::input_iterator InputIt>
+auto when_any(InputIt first, InputIt last) -> Future<when_any_result<std::vector<std::iter_value_t<InputIt>>>>
+{
+    using Sequence = std::vector<std::iter_value_t<InputIt>>;
+
+    struct Context
+    {
+        Sequence futures;
+        std::atomic<std::size_t> index {std::numeric_limits<std::size_t>::max()};
+        std::atomic<std::uint32_t> remaining {2};
+        Promise<when_any_result<Sequence>> promise;
+    };
+
+    auto ctx = std::make_shared<Context>();
+    ctx->futures.assign(std::make_move_iterator(first), std::make_move_iterator(last));
+    auto result = ctx->promise.get_future();
+
+    // Completes after the first ready future and the end of attaching.
+    auto const arrive = [](Context& c) {
+        if (c.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            c.promise.set_value(when_any_result<Sequence> {c.index.load(std::memory_order_relaxed), std::move(c.futures)});
+        }
+    };
+
+    if (ctx->futures.empty())
+    {
+        ctx->remaining.store(1, std::memory_order_relaxed);
+    }
+
+    for (std::size_t i = 0; i != ctx->futures.size(); ++i)
+    {
+        detail::OnReady(ctx->futures[i], true, [ctx, arrive, i] {
+            auto expected = std::numeric_limits<std::size_t>::max();
+            if (ctx->index.compare_exchange_strong(expected, i, std::memory_order_acq_rel))
+            {
+                arrive(*ctx);
+            }
+        });
+    }
+
+    arrive(*ctx);
+    return result;
+}
+
+template<typename... Ts>
+auto when_any(Future<Ts>&&... futures) -> Future<when_any_result<std::tuple<Future<Ts>...>>>
+{
+    using Sequence = std::tuple<Future<Ts>...>;
+
+    struct Context
+    {
+        Sequence futures;
+        std::atomic<std::size_t> index {std::numeric_limits<std::size_t>::max()};
+        std::atomic<std::uint32_t> remaining {sizeof...(Ts) == 0 ? 1U : 2U};
+        Promise<when_any_result<Sequence>> promise;
+    };
+
+    auto ctx    = std::make_shared<Context>(Sequence {std::move(futures)...});
+    auto result = ctx->promise.get_future();
+
+    auto const arrive = [](Context& c) {
+        if (c.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            c.promise.set_value(when_any_result<Sequence> {c.index.load(std::memory_order_relaxed), std::move(c.futures)});
+        }
+    };
+
+    auto attach = [&]<std::size_t... I>(std::index_sequence<I...>) {
+        (detail::OnReady(std::get<I>(ctx->futures), true,
+                                       [ctx, arrive] {
+                                           auto expected = std::numeric_limits<std::size_t>::max();
+                                           if (ctx->index.compare_exchange_strong(expected, I,
+                                                                                  std::memory_order_acq_rel))
+                                           {
+                                               arrive(*ctx);
+                                           }
+                                       }),
+         ...);
+    };
+    attach(std::index_sequence_for<Ts...> {});
+
+    arrive(*ctx);
+    return result;
+}
+
+}  // namespace mc
@@ -1,22 +1,29 @@
 #include "pool.hpp"
 #include "timer.hpp"
 
+#include <cstdio>
 #include <cstdlib>
 
 #include <algorithm>
+#include <array>
 #include <fstream>
 #include <iostream>
 #include <vector>
 
 int main(int, char**)
 {
-    std::vector<std::future<std::vector<char>>> tasks;
+    // MC_TRACE=trace.json records the timers below as a Chrome/Perfetto trace.
+    auto const session = mc::TraceSession {std::getenv("MC_TRACE")};
+
+    using Loads = std::vector<mc::Future<std::vector<char>>>;
+
+    Loads tasks;
     tasks.reserve(128);
 
     {
         mc::ScopedTimer t1 {"Queue"};
         std::generate_n(std::back_inserter(tasks), 128, [] {
-            return mc::Async([] {
+            return mc::Async(mc::QueuePriority::Low, [] {
                 auto input = std::ifstream("/home/tobante/bin/bin/_pcbnew.kiface", std::ios::binary);
                 auto bytes
                     = std::vector<char>((std::istreambuf_iterator<char>(input)), (std::istreambuf_iterator<char>()));
@@ -26,9 +33,41 @@ int main(int, char**)
         });
     }
 
+    // Latency critical work is not stuck behind the file loads.
+    {
+        mc::ScopedTimer t2 {"High"};
+        mc::Async(mc::QueuePriority::High, [] { return 42; }).get();
+    }
+
+    // Fan-in without parking a thread per file: the sum runs on the pool
+    // once the last load is done.
+    {
+        mc::ScopedTimer t3 {"Get"};
+        auto total = mc::when_all(begin(tasks), end(tasks)).then([](Loads loaded) {
+            auto sum = std::size_t {0};
+            for (auto& f : loaded)
+            {
+                sum += f.get().size();
+            }
+            return sum;
+        });
+        std::cout << total.get() << '\n';
+    }
+
+    auto const stats = mc::ThreadPool::GlobalInstance().Stats();
+    auto const names = std::array {"High", "Default", "Low"};
+    for (std::size_t i = 0; i != names.size(); ++i)
+    {
+        auto const& lane = stats.lanes[i];
+        std::printf("%-8s %6llu tasks, wait mean %10.0f ns, max %10llu ns\n", names[i],
+                    static_cast<unsigned long long>(lane.executed), lane.MeanWaitNs(),
+                    static_cast<unsigned long long>(lane.maxWaitNs));
+    }
+
+    // Set MC_THREAD_POOL_METRICS for the per worker breakdown.
+    if (auto const metrics = mc::ThreadPool::GlobalInstance().Metrics(); !metrics.workers.empty())
     {
-        mc::ScopedTimer t2 {"Get"};
-        std::for_each(begin(tasks), end(tasks), [](auto& f) { std::cout << f.get().size() << '\n'; });
+        metrics.WriteText(stdout);
     }
 
     return EXIT_SUCCESS;
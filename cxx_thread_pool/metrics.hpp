@@ -0,0 +1,305 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace mc
+{
+
+/**
+ * @brief Counts of a LatencyHistogram, copied out at one point in time.
+ */
+struct HistogramSnapshot
+{
+    static constexpr auto SubBucketBits = 4U;
+    static constexpr auto SubBuckets    = std::size_t {1} << SubBucketBits;
+    static constexpr auto BucketCount   = (64 - SubBucketBits + 1) * SubBuckets;
+
+    std::array<std::uint64_t, BucketCount> counts {};
+    std::uint64_t count {0};
+    std::uint64_t sum {0};
+    std::uint64_t max {0};
+
+    /// Values below SubBuckets get a bucket each. Above that every power of
+    /// two is split into SubBuckets linear buckets, so a bucket is never
+    /// wider than 1/SubBuckets of its lower bound.
+    [[nodiscard]] static constexpr auto BucketIndex(std::uint64_t value) noexcept -> std::size_t
+    {
+        if (value < SubBuckets)
+        {
+            return static_cast<std::size_t>(value);
+        }
+
+        auto const shift = static_cast<unsigned>(std::bit_width(value)) - 1U - SubBucketBits;
+        auto const sub   = static_cast<std::size_t>(value >> shift) - SubBuckets;
+        return ((shift + 1U) << SubBucketBits) + sub;
+    }
+
+    [[nodiscard]] static constexpr auto BucketLowerBound(std::size_t index) noexcept -> std::uint64_t
+    {
+        if (index < SubBuckets)
+        {
+            return index;
+        }
+
+        auto const group = index >> SubBucketBits;
+        auto const sub   = index & (SubBuckets - 1);
+        return static_cast<std::uint64_t>(SubBuckets + sub) << (group - 1);
+    }
+
+    [[nodiscard]] static constexpr auto BucketUpperBound(std::size_t index) noexcept -> std::uint64_t
+    {
+        if (index < SubBuckets)
+        {
+            return index;
+        }
+        return BucketLowerBound(index) + ((std::uint64_t {1} << ((index >> SubBucketBits) - 1)) - 1);
+    }
+
+    [[nodiscard]] auto Mean() const noexcept -> double
+    {
+        return count == 0 ? 0.0 : static_cast<double>(sum) / static_cast<double>(count);
+    }
+
+    /// Upper bound of the bucket holding the given quantile, 0 <= q <= 1,
+    /// clamped to the largest recorded value.
+    [[nodiscard]] auto Quantile(double q) const noexcept -> std::uint64_t
+    {
+        // Not count: a snapshot taken while others record may disagree.
+        auto total = std::uint64_t {0};
+        for (auto const c : counts)
+        {
+            total += c;
+        }
+        if (total == 0)
+        {
+            return 0;
+        }
+
+        auto const rank = static_cast<std::uint64_t>(q * static_cast<double>(total - 1)) + 1;
+        auto seen       = std::uint64_t {0};
+        for (std::size_t i = 0; i != counts.size(); ++i)
+        {
+            seen += counts[i];
+            if (seen >= rank)
+            {
+                return BucketUpperBound(i) < max ? BucketUpperBound(i) : max;
+            }
+        }
+        return max;
+    }
+
+    auto Merge(HistogramSnapshot const& other) noexcept -> void
+    {
+        for (std::size_t i = 0; i != counts.size(); ++i)
+        {
+            counts[i] += other.counts[i];
+        }
+        count += other.count;
+        sum += other.sum;
+        max = max > other.max ? max : other.max;
+    }
+};
+
+/**
+ * @brief Log-linear histogram of durations in nanoseconds, in the style of
+ * HdrHistogram. Recording is a relaxed increment, so any number of threads
+ * may record and any thread may take a snapshot without stopping them. A
+ * snapshot taken while others record can be off by the values in flight.
+ */
+class LatencyHistogram
+{
+public:
+    auto Record(std::uint64_t ns) noexcept -> void
+    {
+        counts_[HistogramSnapshot::BucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(ns, std::memory_order_relaxed);
+        auto max = max_.load(std::memory_order_relaxed);
+        while (ns > max && !max_.compare_exchange_weak(max, ns, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    [[nodiscard]] auto Snapshot() const noexcept -> HistogramSnapshot
+    {
+        auto snapshot = HistogramSnapshot {};
+        for (std::size_t i = 0; i != counts_.size(); ++i)
+        {
+            snapshot.counts[i] = counts_[i].load(std::memory_order_relaxed);
+        }
+        snapshot.count = count_.load(std::memory_order_relaxed);
+        snapshot.sum   = sum_.load(std::memory_order_relaxed);
+        snapshot.max   = max_.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+
+private:
+    std::array<std::atomic<std::uint64_t>, HistogramSnapshot::BucketCount> counts_ {};
+    std::atomic<std::uint64_t> count_ {0};
+    std::atomic<std::uint64_t> sum_ {0};
+    std::atomic<std::uint64_t> max_ {0};
+};
+
+/**
+ * @brief What one worker, or all threads outside the pool together, did.
+ */
+struct WorkerMetricsSnapshot
+{
+    HistogramSnapshot wait;       ///< enqueue to start
+    HistogramSnapshot run;        ///< start to finish
+    std::uint64_t steals {0};     ///< tasks taken from another worker
+    std::uint64_t failedPush {0}; ///< TryPush to this worker's inbox that found it locked
+    std::uint64_t failedPop {0};  ///< TryPop by this worker that found an inbox locked
+    std::uint64_t sleeps {0};
+    std::uint64_t idleNs {0};     ///< time asleep waiting for work
+    std::int64_t depth {0};       ///< tasks in this worker's deques
+
+    auto Merge(WorkerMetricsSnapshot const& other) noexcept -> void
+    {
+        wait.Merge(other.wait);
+        run.Merge(other.run);
+        steals += other.steals;
+        failedPush += other.failedPush;
+        failedPop += other.failedPop;
+        sleeps += other.sleeps;
+        idleNs += other.idleNs;
+        depth += other.depth;
+    }
+};
+
+/**
+ * @brief Snapshot of ThreadPool::Metrics().
+ */
+struct ThreadPoolMetrics
+{
+    std::vector<WorkerMetricsSnapshot> workers;
+
+    /// Tasks run through TryRunPendingTask by threads outside the pool.
+    WorkerMetricsSnapshot external;
+
+    /// Submitted but not yet started, indexed by ThreadPool::Lane. Tasks
+    /// with a deadline are counted here and in queuedDeadline.
+    std::array<std::int64_t, 3> queued {};
+    std::int64_t queuedDeadline {0};
+
+    [[nodiscard]] auto Total() const noexcept -> WorkerMetricsSnapshot
+    {
+        auto total = external;
+        for (auto const& w : workers)
+        {
+            total.Merge(w);
+        }
+        return total;
+    }
+
+    auto WriteText(std::FILE* out) const -> void
+    {
+        std::fprintf(out, "queued: high %lld, default %lld, low %lld, deadline %lld\n",
+                     static_cast<long long>(queued[0]), static_cast<long long>(queued[1]),
+                     static_cast<long long>(queued[2]), static_cast<long long>(queuedDeadline));
+        std::fprintf(out, "%-9s %9s %9s %9s %9s %9s %9s %9s %7s %7s %7s %10s %6s\n", "worker", "tasks", "wait p50",
+                     "wait p99", "wait max", "run p50", "run p99", "run max", "steals", "fpush", "fpop", "idle ms",
+                     "depth");
+
+        auto row = [out](char const* name, WorkerMetricsSnapshot const& w) {
+            auto const us = [](std::uint64_t ns) { return static_cast<double>(ns) / 1'000.0; };
+            std::fprintf(out, "%-9s %9llu %7.1fus %7.1fus %7.1fus %7.1fus %7.1fus %7.1fus %7llu %7llu %7llu %10.1f %6lld\n",
+                         name, static_cast<unsigned long long>(w.wait.count), us(w.wait.Quantile(0.5)),
+                         us(w.wait.Quantile(0.99)), us(w.wait.max), us(w.run.Quantile(0.5)), us(w.run.Quantile(0.99)),
+                         us(w.run.max), static_cast<unsigned long long>(w.steals),
+                         static_cast<unsigned long long>(w.failedPush), static_cast<unsigned long long>(w.failedPop),
+                         static_cast<double>(w.idleNs) / 1e6, static_cast<long long>(w.depth));
+        };
+
+        char name[16];
+        for (std::size_t i = 0; i != workers.size(); ++i)
+        {
+            std::snprintf(name, sizeof(name), "%zu", i);
+            row(name, workers[i]);
+        }
+        row("external", external);
+        row("total", Total());
+    }
+
+    auto WriteJson(std::FILE* out) const -> void
+    {
+        auto histogram = [out](char const* name, HistogramSnapshot const& h) {
+            std::fprintf(out,
+                         "\"%s\": {\"count\": %llu, \"mean_ns\": %.1f, \"p50_ns\": %llu, \"p90_ns\": %llu"
+                         ", \"p99_ns\": %llu, \"p999_ns\": %llu, \"max_ns\": %llu}",
+                         name, static_cast<unsigned long long>(h.count), h.Mean(),
+                         static_cast<unsigned long long>(h.Quantile(0.5)),
+                         static_cast<unsigned long long>(h.Quantile(0.9)),
+                         static_cast<unsigned long long>(h.Quantile(0.99)),
+                         static_cast<unsigned long long>(h.Quantile(0.999)), static_cast<unsigned long long>(h.max));
+        };
+
+        auto worker = [out, &histogram](WorkerMetricsSnapshot const& w) {
+            std::fprintf(out, "{");
+            histogram("wait", w.wait);
+            std::fprintf(out, ", ");
+            histogram("run", w.run);
+            std::fprintf(out,
+                         ", \"steals\": %llu, \"failed_push\": %llu, \"failed_pop\": %llu, \"sleeps\": %llu"
+                         ", \"idle_ns\": %llu, \"depth\": %lld}",
+                         static_cast<unsigned long long>(w.steals), static_cast<unsigned long long>(w.failedPush),
+                         static_cast<unsigned long long>(w.failedPop), static_cast<unsigned long long>(w.sleeps),
+                         static_cast<unsigned long long>(w.idleNs), static_cast<long long>(w.depth));
+        };
+
+        std::fprintf(out, "{\"queued\": {\"high\": %lld, \"default\": %lld, \"low\": %lld, \"deadline\": %lld}",
+                     static_cast<long long>(queued[0]), static_cast<long long>(queued[1]),
+                     static_cast<long long>(queued[2]), static_cast<long long>(queuedDeadline));
+        std::fprintf(out, ",\n \"workers\": [");
+        for (std::size_t i = 0; i != workers.size(); ++i)
+        {
+            std::fprintf(out, "%s\n  ", i == 0 ? "" : ",");
+            worker(workers[i]);
+        }
+        std::fprintf(out, "],\n \"external\": ");
+        worker(external);
+        std::fprintf(out, ",\n \"total\": ");
+        worker(Total());
+        std::fprintf(out, "}\n");
+    }
+};
+
+namespace detail
+{
+
+// Written by the owning worker, except failedPush which submitters bump on
+// the worker they tried to push to. Read by ThreadPool::Metrics().
+struct WorkerMetrics
+{
+    LatencyHistogram wait;
+    LatencyHistogram run;
+    std::atomic<std::uint64_t> steals {0};
+    std::atomic<std::uint64_t> failedPop {0};
+    std::atomic<std::uint64_t> sleeps {0};
+    std::atomic<std::uint64_t> idleNs {0};
+
+    alignas(64) std::atomic<std::uint64_t> failedPush {0};
+
+    [[nodiscard]] auto Snapshot() const noexcept -> WorkerMetricsSnapshot
+    {
+        auto snapshot       = WorkerMetricsSnapshot {};
+        snapshot.wait       = wait.Snapshot();
+        snapshot.run        = run.Snapshot();
+        snapshot.steals     = steals.load(std::memory_order_relaxed);
+        snapshot.failedPush = failedPush.load(std::memory_order_relaxed);
+        snapshot.failedPop  = failedPop.load(std::memory_order_relaxed);
+        snapshot.sleeps     = sleeps.load(std::memory_order_relaxed);
+        snapshot.idleNs     = idleNs.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+};
+
+}  // namespace detail
+
+}  // namespace mc
@@ -0,0 +1,319 @@
+#pragma once
+
+#include "pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <ranges>
+#include <thread>
+#include <vector>
+
+namespace mc
+{
+
+/**
+ * @brief Fork-join scope on a ThreadPool.
+ *
+ * Wait() runs queued pool tasks on the calling thread until every task of
+ * the group has finished, so nested groups on a fixed-size pool can not
+ * deadlock. The first exception thrown by a task is rethrown from Wait().
+ */
+class TaskGroup
+{
+public:
+    explicit TaskGroup(ThreadPool& pool = ThreadPool::GlobalInstance()) : pool_ {pool} { }
+
+    TaskGroup(TaskGroup const&) = delete;
+    TaskGroup(TaskGroup&&)      = delete;
+
+    auto operator=(TaskGroup const&) -> TaskGroup& = delete;
+    auto operator=(TaskGroup&&) -> TaskGroup& = delete;
+
+    ~TaskGroup() noexcept { join(); }
+
+    template<typename Func>
+    auto Run(Func&& func) -> void
+    {
+        pending_.fetch_add(1, std::memory_order_relaxed);
+        pool_.Async([this, f = std::forward<Func>(func)]() mutable {
+            try
+            {
+                f();
+            }
+            catch (...)
+            {
+                auto lock = std::scoped_lock {mutex_};
+                if (!exception_)
+                {
+                    exception_ = std::current_exception();
+                }
+            }
+
+            // Same as std::latch::count_down, notify only passes the address
+            // to the futex and is fine after the waiter already returned.
+            if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                pending_.notify_all();
+            }
+        });
+    }
+
+    auto Wait() -> void
+    {
+        join();
+        if (exception_)
+        {
+            std::rethrow_exception(std::exchange(exception_, nullptr));
+        }
+    }
+
+private:
+    auto join() noexcept -> void
+    {
+        auto spins = 0;
+        while (true)
+        {
+            auto const pending = pending_.load(std::memory_order_acquire);
+            if (pending == 0)
+            {
+                return;
+            }
+
+            if (pool_.TryRunPendingTask())
+            {
+                spins = 0;
+                continue;
+            }
+
+            // Our remaining tasks are running elsewhere.
+            if (++spins < 64)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            pending_.wait(pending, std::memory_order_acquire);
+        }
+    }
+
+    ThreadPool& pool_;
+    std::atomic<std::uint32_t> pending_ {0};
+    std::mutex mutex_;
+    std::exception_ptr exception_;
+};
+
+namespace detail
+{
+
+// Enough leaves for every worker to steal a few times, without making the
+// leaves so small that spawning dominates.
+inline auto AutoGrain(ThreadPool const& pool, std::size_t size, std::size_t grain) -> std::size_t
+{
+    if (grain != 0)
+    {
+        return grain;
+    }
+
+    return std::max<std::size_t>(1, size / ((pool.Size() + 1) * 8));
+}
+
+template<typename Body>
+auto ForkJoin(ThreadPool& pool, std::size_t first, std::size_t last, std::size_t grain, Body& body) -> void
+{
+    if (last - first <= grain)
+    {
+        body(first, last);
+        return;
+    }
+
+    auto const mid = first + (last - first) / 2;
+    auto group     = TaskGroup {pool};
+    group.Run([&pool, mid, last, grain, &body] { ForkJoin(pool, mid, last, grain, body); });
+    ForkJoin(pool, first, mid, grain, body);
+    group.Wait();
+}
+
+template<typename T, typename Leaf, typename Combine>
+auto ForkJoinReduce(ThreadPool& pool, std::size_t first, std::size_t last, std::size_t grain, Leaf& leaf,
+                    Combine& combine) -> T
+{
+    if (last - first <= grain)
+    {
+        return leaf(first, last);
+    }
+
+    auto const mid = first + (last - first) / 2;
+    auto right     = std::optional<T> {};
+    auto group     = TaskGroup {pool};
+    group.Run([&] { right.emplace(ForkJoinReduce<T>(pool, mid, last, grain, leaf, combine)); });
+    auto left = ForkJoinReduce<T>(pool, first, mid, grain, leaf, combine);
+    group.Wait();
+    return combine(std::move(left), std::move(*right));
+}
+
+}  // namespace detail
+
+/**
+ * @brief Calls func(element) for every element of a random-access range.
+ *
+ * The range is split recursively until a piece is at most grain elements
+ * long. A grain of 0 picks one from the range and pool size.
+ */
+template<std::ranges::random_access_range Range, typename Func>
+auto parallel_for(Range&& range, Func func, std::size_t grain = 0) -> void
+{
+    auto& pool        = ThreadPool::GlobalInstance();
+    auto const first  = std::ranges::begin(range);
+    auto const size   = static_cast<std::size_t>(std::ranges::distance(range));
+    auto const leaves = detail::AutoGrain(pool, size, grain);
+
+    auto body = [first, &func](std::size_t b, std::size_t e) {
+        for (auto i = b; i != e; ++i)
+        {
+            std::invoke(func, first[static_cast<std::ranges::range_difference_t<Range>>(i)]);
+        }
+    };
+
+    detail::ForkJoin(pool, 0, size, leaves, body);
+}
+
+/**
+ * @brief Writes func(in[i]) to out[i] for every element of in. Returns the
+ * end of the output.
+ */
+template<std::ranges::random_access_range Range, std::random_access_iterator Out, typename Func>
+auto parallel_transform(Range&& in, Out out, Func func, std::size_t grain = 0) -> Out
+{
+    auto& pool        = ThreadPool::GlobalInstance();
+    auto const first  = std::ranges::begin(in);
+    auto const size   = static_cast<std::size_t>(std::ranges::distance(in));
+    auto const leaves = detail::AutoGrain(pool, size, grain);
+
+    auto body = [first, out, &func](std::size_t b, std::size_t e) {
+        for (auto i = b; i != e; ++i)
+        {
+            out[static_cast<std::iter_difference_t<Out>>(i)]
+                = std::invoke(func, first[static_cast<std::ranges::range_difference_t<Range>>(i)]);
+        }
+    };
+
+    detail::ForkJoin(pool, 0, size, leaves, body);
+    return out + static_cast<std::iter_difference_t<Out>>(size);
+}
+
+/**
+ * @brief Folds the range with an associative op. Pieces are combined in
+ * range order, so op does not have to be commutative.
+ */
+template<std::ranges::random_access_range Range, typename T, typename BinaryOp = std::plus<>>
+auto parallel_reduce(Range&& range, T init, BinaryOp op = {}, std::size_t grain = 0) -> T
+{
+    auto& pool        = ThreadPool::GlobalInstance();
+    auto const first  = std::ranges::begin(range);
+    auto const size   = static_cast<std::size_t>(std::ranges::distance(range));
+    auto const leaves = detail::AutoGrain(pool, size, grain);
+
+    if (size == 0)
+    {
+        return init;
+    }
+
+    auto leaf = [first, &op](std::size_t b, std::size_t e) {
+        auto acc = T(first[static_cast<std::ranges::range_difference_t<Range>>(b)]);
+        for (auto i = b + 1; i != e; ++i)
+        {
+            acc = std::invoke(op, std::move(acc), first[static_cast<std::ranges::range_difference_t<Range>>(i)]);
+        }
+        return acc;
+    };
+
+    auto combine = [&op](T lhs, T rhs) { return std::invoke(op, std::move(lhs), std::move(rhs)); };
+    return std::invoke(op, std::move(init), detail::ForkJoinReduce<T>(pool, 0, size, leaves, leaf, combine));
+}
+
+/**
+ * @brief Writes the inclusive prefix fold of in to out. Two passes over
+ * blocks: reduce every block in parallel, scan the few block totals
+ * serially, then scan every block in parallel seeded with its offset.
+ */
+template<std::ranges::random_access_range Range, std::random_access_iterator Out, typename BinaryOp = std::plus<>>
+auto parallel_inclusive_scan(Range&& in, Out out, BinaryOp op = {}, std::size_t grain = 0) -> Out
+{
+    using value_type = std::ranges::range_value_t<Range>;
+    using in_diff    = std::ranges::range_difference_t<Range>;
+    using out_diff   = std::iter_difference_t<Out>;
+
+    auto& pool       = ThreadPool::GlobalInstance();
+    auto const first = std::ranges::begin(in);
+    auto const size  = static_cast<std::size_t>(std::ranges::distance(in));
+    auto const block = detail::AutoGrain(pool, size, grain);
+
+    if (size == 0)
+    {
+        return out;
+    }
+
+    auto const blocks = (size + block - 1) / block;
+    auto totals       = std::vector<std::optional<value_type>>(blocks);
+
+    auto const scanBlock = [&](std::size_t b, std::optional<value_type> const& carry, bool write) {
+        auto const begin = b * block;
+        auto const end   = std::min(size, begin + block);
+        auto acc         = carry ? std::invoke(op, *carry, first[static_cast<in_diff>(begin)])
+                                 : value_type(first[static_cast<in_diff>(begin)]);
+        if (write)
+        {
+            out[static_cast<out_diff>(begin)] = acc;
+        }
+
+        for (auto i = begin + 1; i != end; ++i)
+        {
+            acc = std::invoke(op, std::move(acc), first[static_cast<in_diff>(i)]);
+            if (write)
+            {
+                out[static_cast<out_diff>(i)] = acc;
+            }
+        }
+        return acc;
+    };
+
+    // Pass 1: block totals. The last block's total is never needed.
+    auto reduceBlocks = [&](std::size_t b, std::size_t e) {
+        for (auto i = b; i != e; ++i)
+        {
+            totals[i] = scanBlock(i, std::nullopt, false);
+        }
+    };
+    detail::ForkJoin(pool, 0, blocks - 1, 1, reduceBlocks);
+
+    // Exclusive scan over the block totals.
+    auto carry = std::optional<value_type> {};
+    for (auto& total : totals)
+    {
+        auto const blockTotal = std::exchange(total, carry);
+        if (blockTotal)
+        {
+            carry = carry ? std::optional<value_type> {std::invoke(op, *carry, *blockTotal)} : blockTotal;
+        }
+    }
+
+    // Pass 2: scan each block with its carry-in.
+    auto scanBlocks = [&](std::size_t b, std::size_t e) {
+        for (auto i = b; i != e; ++i)
+        {
+            scanBlock(i, totals[i], true);
+        }
+    };
+    detail::ForkJoin(pool, 0, blocks, 1, scanBlocks);
+
+    return out + static_cast<out_diff>(size);
+}
+
+}  // namespace mc
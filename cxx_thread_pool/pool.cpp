@@ -1,11 +1,25 @@
 #include "pool.hpp"
 
+#include <cstdlib>
+
 namespace mc
 {
 auto ThreadPool::GlobalInstance() -> ThreadPool&
 {
-    static ThreadPool instance {8};
+    // One worker per usable CPU. Set MC_THREAD_POOL_PIN to pin them and
+    // MC_THREAD_POOL_METRICS to record ThreadPool::Metrics().
+    static ThreadPool instance {[] {
+        auto options       = ThreadPoolOptions {};
+        options.pinWorkers = std::getenv("MC_THREAD_POOL_PIN") != nullptr;
+        options.metrics    = std::getenv("MC_THREAD_POOL_METRICS") != nullptr;
+        return options;
+    }()};
     return instance;
 }
 
+namespace detail
+{
+auto ScheduleContinuation(Task&& task) -> void { ThreadPool::GlobalInstance().Async(std::move(task)); }
+}  // namespace detail
+
 }  // namespace mc
\ No newline at end of file
@@ -1,24 +1,146 @@
 #pragma once
 
+#include "event_count.hpp"
+#include "future.hpp"
+#include "metrics.hpp"
 #include "queue.hpp"
+#include "slab.hpp"
+#include "task.hpp"
+#include "topology.hpp"
+#include "work_stealing_deque.hpp"
 
 #include <algorithm>
+#include <array>
 #include <atomic>
-#include <future>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <latch>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
 namespace mc
 {
 
+/**
+ * @brief Tag enum for selecting the async queue priority when dispatching tasks with mc::Async.
+ *
+ * Same values as in cxx_linux_libdispatch. There is no main queue here,
+ * Message tasks share the High lane.
+ */
+enum class QueuePriority
+{
+    Default,
+    Low,
+    High,
+    Message,
+};
+
+struct TaskOptions
+{
+    QueuePriority priority {QueuePriority::Default};
+
+    /// Tasks with a deadline are started earliest deadline first, ahead of
+    /// every lane. A task that starts late still runs and counts as a miss.
+    std::optional<std::chrono::steady_clock::time_point> deadline {};
+};
+
+struct ThreadPoolOptions
+{
+    /// 0 sizes the pool from the usable CPUs and the cgroup quota.
+    std::size_t threadCount {0};
+
+    /// Pin worker i to the i-th CPU of the topology.
+    bool pinWorkers {false};
+
+    /// Queued low priority work jumps ahead of the other lanes once no low
+    /// priority task has started for this long.
+    std::chrono::microseconds lowPriorityAging {10'000};
+
+    /// Record per worker wait and run time histograms and queue counters,
+    /// see ThreadPool::Metrics(). Costs one more clock read and a few
+    /// relaxed atomic increments per task.
+    bool metrics {false};
+};
+
+struct LaneStats
+{
+    std::uint64_t executed {0};
+    std::uint64_t totalWaitNs {0};
+    std::uint64_t maxWaitNs {0};
+
+    [[nodiscard]] auto MeanWaitNs() const noexcept -> double
+    {
+        return executed == 0 ? 0.0 : static_cast<double>(totalWaitNs) / static_cast<double>(executed);
+    }
+};
+
+/**
+ * @brief Time from submission to start, per lane, summed over all workers.
+ */
+struct SchedulerStats
+{
+    /// Indexed by ThreadPool::Lane.
+    std::array<LaneStats, 3> lanes {};
+    std::uint64_t deadlineTasks {0};
+    std::uint64_t deadlineMisses {0};
+};
+
 class ThreadPool
 {
 public:
-    explicit ThreadPool(std::size_t threadCount) : count_ {threadCount}
+    enum Lane : std::uint8_t
+    {
+        HighLane,
+        DefaultLane,
+        LowLane,
+        LaneCount,
+    };
+
+    explicit ThreadPool(std::size_t threadCount) : ThreadPool {ThreadPoolOptions {threadCount}} { }
+
+    explicit ThreadPool(ThreadPoolOptions options, Topology const& topology = DiscoverTopology())
+        : count_ {options.threadCount != 0 ? options.threadCount : topology.ThreadCount()}
+        , aging_ {std::chrono::duration_cast<std::chrono::nanoseconds>(options.lowPriorityAging).count()}
+        , workers_(count_)
+        , victims_(count_)
+        , started_ {static_cast<std::ptrdiff_t>(count_)}
+        , metrics_ {options.metrics}
+        , externalMetrics_ {options.metrics ? std::make_unique<detail::WorkerMetrics>() : nullptr}
     {
+        auto cpus = std::vector<std::optional<CpuInfo>>(count_);
+        if (options.pinWorkers && !topology.cpus.empty())
+        {
+            for (std::size_t i = 0; i < count_; ++i)
+            {
+                cpus[i] = topology.cpus[i % topology.cpus.size()];
+            }
+        }
+
+        // Steal from workers on the same NUMA node before crossing sockets.
         for (std::size_t i = 0; i < count_; ++i)
         {
-            threads_.emplace_back([&, i] { run(i); });
+            for (std::size_t n = 1; n < count_; ++n)
+            {
+                victims_[i].push_back((i + n) % count_);
+            }
+
+            std::stable_partition(victims_[i].begin(), victims_[i].end(), [&](auto v) {
+                return !cpus[i] || cpus[i]->node == cpus[v]->node;
+            });
         }
+
+        for (std::size_t i = 0; i < count_; ++i)
+        {
+            threads_.emplace_back([this, i, cpu = cpus[i]] { run(i, cpu); });
+        }
+
+        started_.wait();
     }
 
     ThreadPool(ThreadPool const&) noexcept = delete;
@@ -29,75 +151,479 @@ public:
 
     ~ThreadPool() noexcept
     {
-        std::for_each(queues_.begin(), queues_.end(), [](auto& q) { q.Done(); });
+        done_.store(true, std::memory_order_seq_cst);
+        idle_.NotifyAll();
         std::for_each(threads_.begin(), threads_.end(), [](auto& t) { t.join(); });
     }
 
     [[nodiscard]] static auto GlobalInstance() -> ThreadPool&;
 
+    [[nodiscard]] auto Size() const noexcept -> std::size_t { return count_; }
+
+    /// Snapshot of the queueing latency counters. Safe to call from any
+    /// thread while the pool is running.
+    [[nodiscard]] auto Stats() const -> SchedulerStats
+    {
+        auto stats = SchedulerStats {};
+        auto add   = [&stats](std::array<LaneCounters, LaneCount> const& counters) {
+            for (std::size_t lane = 0; lane != LaneCount; ++lane)
+            {
+                auto& s = stats.lanes[lane];
+                s.executed += counters[lane].executed.load(std::memory_order_relaxed);
+                s.totalWaitNs += counters[lane].totalWaitNs.load(std::memory_order_relaxed);
+                s.maxWaitNs = std::max(s.maxWaitNs, counters[lane].maxWaitNs.load(std::memory_order_relaxed));
+            }
+        };
+
+        std::for_each(workers_.begin(), workers_.end(), [&](auto const& w) { add(w->counters); });
+        add(externalCounters_);
+        stats.deadlineTasks  = deadlineTasks_.load(std::memory_order_relaxed);
+        stats.deadlineMisses = deadlineMisses_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    /// Snapshot of the per worker metrics, empty unless the pool was created
+    /// with ThreadPoolOptions::metrics. Safe to call from any thread while
+    /// the pool is running; the workers never wait for it.
+    [[nodiscard]] auto Metrics() const -> ThreadPoolMetrics
+    {
+        auto metrics = ThreadPoolMetrics {};
+        if (!metrics_)
+        {
+            return metrics;
+        }
+
+        for (auto const& w : workers_)
+        {
+            auto& snapshot = metrics.workers.emplace_back(w->metrics->Snapshot());
+            for (auto const& deque : w->deques)
+            {
+                snapshot.depth += deque.Size();
+            }
+        }
+        metrics.external = externalMetrics_->Snapshot();
+
+        auto const stats = Stats();
+        for (std::size_t lane = 0; lane != LaneCount; ++lane)
+        {
+            auto const submitted = submitted_[lane].load(std::memory_order_relaxed);
+            auto const started   = static_cast<std::int64_t>(stats.lanes[lane].executed);
+            metrics.queued[lane] = std::max<std::int64_t>(0, submitted - started);
+        }
+        metrics.queuedDeadline = static_cast<std::int64_t>(deadlineCount_.load(std::memory_order_relaxed));
+        return metrics;
+    }
+
+    /// Runs one queued task on the calling thread, if there is one. Lets a
+    /// thread that blocks on pool work help instead of idling.
+    auto TryRunPendingTask() -> bool
+    {
+        auto* job = currentPool_ == this ? findJob(currentIndex_) : findJob(std::nullopt);
+        if (job == nullptr)
+        {
+            return false;
+        }
+
+        execute(job);
+        return true;
+    }
+
     template<typename Func>
-    auto Async(Func&& func)
+    auto Async(Func&& func) -> void
     {
+        Async(TaskOptions {}, std::forward<Func>(func));
+    }
+
+    template<typename Func>
+    auto Async(QueuePriority priority, Func&& func) -> void
+    {
+        Async(TaskOptions {priority}, std::forward<Func>(func));
+    }
+
+    template<typename Func>
+    auto Async(TaskOptions const& options, Func&& func) -> void
+    {
+        auto const now  = Now();
+        auto const lane = ToLane(options.priority);
+        auto* job       = ::new (SlabAllocate(sizeof(Job))) Job {Task {std::forward<Func>(func)}, now, 0, lane};
+
+        if (metrics_)
+        {
+            submitted_[lane].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (options.deadline)
+        {
+            job->deadline = options.deadline->time_since_epoch() / std::chrono::nanoseconds {1};
+            pushDeadlineJob(job);
+            idle_.NotifyOne();
+            return;
+        }
+
+        // Counted before the push, so a non-zero count never hides a job
+        // from findJob. Default is not counted, it is always searched.
+        if (lane != DefaultLane && pending_[lane].fetch_add(1, std::memory_order_seq_cst) == 0 && lane == LowLane)
+        {
+            lastLowStart_.store(now, std::memory_order_relaxed);
+        }
+
+        // Spawned from one of our workers, keep it local. Thieves take it
+        // from the other end if this worker stays busy.
+        if (currentPool_ == this)
+        {
+            workers_[currentIndex_]->deques[lane].Push(job);
+            idle_.NotifyOne();
+            return;
+        }
+
         auto const i     = index_++;
         constexpr auto K = 2;
 
         for (std::size_t n = 0; n != count_ * K; ++n)
         {
-            if (queues_[(i + n) % count_].TryPush(std::forward<Func>(func)))
+            auto& worker = *workers_[(i + n) % count_];
+            if (worker.inboxes[lane].TryPush(job))
             {
+                idle_.NotifyOne();
                 return;
             }
+            if (worker.metrics)
+            {
+                worker.metrics->failedPush.fetch_add(1, std::memory_order_relaxed);
+            }
         }
 
-        queues_[i % count_].Push(std::forward<Func>(func));
+        workers_[i % count_]->inboxes[lane].Push(job);
+        idle_.NotifyOne();
     }
 
 private:
-    void run(std::size_t id)
+    struct Job
+    {
+        Task task;
+        std::int64_t enqueued;
+        std::int64_t deadline;
+        Lane lane;
+    };
+
+    struct LaterDeadline
+    {
+        auto operator()(Job const* lhs, Job const* rhs) const noexcept -> bool { return lhs->deadline > rhs->deadline; }
+    };
+
+    struct LaneCounters
+    {
+        std::atomic<std::uint64_t> executed {0};
+        std::atomic<std::uint64_t> totalWaitNs {0};
+        std::atomic<std::uint64_t> maxWaitNs {0};
+    };
+
+    struct Worker
+    {
+        std::array<WorkStealingDeque<Job*>, LaneCount> deques;
+        std::array<BasicNotificationQueue<Job*>, LaneCount> inboxes;
+
+        // Only written by the owning worker, read by Stats().
+        alignas(64) std::array<LaneCounters, LaneCount> counters;
+
+        // Null unless ThreadPoolOptions::metrics is set.
+        std::unique_ptr<detail::WorkerMetrics> metrics;
+    };
+
+    [[nodiscard]] static auto Now() noexcept -> std::int64_t
+    {
+        return std::chrono::steady_clock::now().time_since_epoch() / std::chrono::nanoseconds {1};
+    }
+
+    [[nodiscard]] static constexpr auto ToLane(QueuePriority priority) noexcept -> Lane
+    {
+        switch (priority)
+        {
+            case QueuePriority::High:
+            case QueuePriority::Message: return HighLane;
+            case QueuePriority::Low: return LowLane;
+            default: return DefaultLane;
+        }
+    }
+
+    auto pushDeadlineJob(Job* job) -> void
+    {
+        auto const lock = std::scoped_lock {deadlineMutex_};
+        deadlineJobs_.push_back(job);
+        std::push_heap(deadlineJobs_.begin(), deadlineJobs_.end(), LaterDeadline {});
+        deadlineCount_.fetch_add(1, std::memory_order_seq_cst);
+    }
+
+    auto popDeadlineJob() -> Job*
+    {
+        auto const lock = std::scoped_lock {deadlineMutex_};
+        if (deadlineJobs_.empty())
+        {
+            return nullptr;
+        }
+
+        std::pop_heap(deadlineJobs_.begin(), deadlineJobs_.end(), LaterDeadline {});
+        auto* job = deadlineJobs_.back();
+        deadlineJobs_.pop_back();
+        deadlineCount_.fetch_sub(1, std::memory_order_relaxed);
+        return job;
+    }
+
+    // Deadlines first, then High, Default, Low. Low moves to the front once
+    // it has been passed over for longer than the aging threshold. Without
+    // a worker id only steals, for threads outside the pool.
+    auto findJob(std::optional<std::size_t> id) -> Job*
+    {
+        if (deadlineCount_.load(std::memory_order_seq_cst) != 0)
+        {
+            if (auto* job = popDeadlineJob(); job != nullptr)
+            {
+                return job;
+            }
+        }
+
+        auto order     = std::array<Lane, LaneCount> {HighLane, DefaultLane, LowLane};
+        auto const low = pending_[LowLane].load(std::memory_order_seq_cst) != 0;
+        if (low && Now() - lastLowStart_.load(std::memory_order_relaxed) > aging_)
+        {
+            order = {LowLane, HighLane, DefaultLane};
+        }
+
+        for (auto const lane : order)
+        {
+            if (lane != DefaultLane && pending_[lane].load(std::memory_order_seq_cst) == 0)
+            {
+                continue;
+            }
+
+            auto* job = id ? findJob(*id, lane) : stealJob(index_.load(std::memory_order_relaxed), lane);
+            if (job != nullptr)
+            {
+                return job;
+            }
+        }
+
+        return nullptr;
+    }
+
+    auto findJob(std::size_t id, Lane lane) -> Job*
+    {
+        Job* job       = nullptr;
+        auto& self     = *workers_[id];
+        auto contended = false;
+
+        // Own work first: LIFO from the deque, then anything submitted
+        // from outside the pool.
+        if (self.deques[lane].Pop(job) || self.inboxes[lane].TryPop(job, contended))
+        {
+            return job;
+        }
+        if (contended && self.metrics)
+        {
+            self.metrics->failedPop.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        for (auto const v : victims_[id])
+        {
+            if (trySteal(*workers_[v], lane, job, self.metrics.get()))
+            {
+                return job;
+            }
+        }
+
+        return nullptr;
+    }
+
+    auto stealJob(std::size_t first, Lane lane) -> Job*
+    {
+        Job* job = nullptr;
+        for (std::size_t n = 0; n != count_; ++n)
+        {
+            if (trySteal(*workers_[(first + n) % count_], lane, job, externalMetrics_.get()))
+            {
+                return job;
+            }
+        }
+
+        return nullptr;
+    }
+
+    static auto trySteal(Worker& victim, Lane lane, Job*& job, detail::WorkerMetrics* thief) -> bool
+    {
+        auto contended = false;
+        auto const won = victim.deques[lane].Steal(job) || victim.inboxes[lane].TryPop(job, contended);
+        if (thief != nullptr)
+        {
+            if (won)
+            {
+                thief->steals.fetch_add(1, std::memory_order_relaxed);
+            }
+            else if (contended)
+            {
+                thief->failedPop.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        return won;
+    }
+
+    void run(std::size_t id, std::optional<CpuInfo> cpu)
     {
+        if (cpu)
+        {
+            PinCurrentThread(cpu->id);
+        }
+
+        // Allocated after pinning, so the queues are first touched on the
+        // worker's own NUMA node.
+        workers_[id] = std::make_unique<Worker>();
+        if (metrics_)
+        {
+            workers_[id]->metrics = std::make_unique<detail::WorkerMetrics>();
+        }
+        started_.arrive_and_wait();
+
+        auto* metrics = workers_[id]->metrics.get();
+
+        currentPool_  = this;
+        currentIndex_ = id;
+
         while (true)
         {
-            NotificationQueue::value_type func;
+            if (auto* job = findJob(id); job != nullptr)
+            {
+                execute(job);
+                continue;
+            }
+
+            auto const key = idle_.PrepareWait();
 
-            for (std::size_t n = 0; n != count_; ++n)
+            if (auto* job = findJob(id); job != nullptr)
             {
-                if (auto const index = (id + n) % count_; queues_[index].TryPop(func))
-                {
-                    break;
-                }
+                idle_.CancelWait();
+                execute(job);
+                continue;
             }
 
-            if (!func && !queues_[id].Pop(func))
+            if (done_.load(std::memory_order_seq_cst))
             {
+                idle_.CancelWait();
                 break;
             }
 
-            func();
+            if (metrics == nullptr)
+            {
+                idle_.CommitWait(key);
+                continue;
+            }
+
+            auto const sleep = Now();
+            idle_.CommitWait(key);
+            metrics->sleeps.fetch_add(1, std::memory_order_relaxed);
+            metrics->idleNs.fetch_add(static_cast<std::uint64_t>(Now() - sleep), std::memory_order_relaxed);
         }
     }
 
+    auto execute(Job* job) -> void
+    {
+        auto const start = Now();
+        auto const wait  = static_cast<std::uint64_t>(std::max<std::int64_t>(0, start - job->enqueued));
+
+        if (job->deadline != 0)
+        {
+            deadlineTasks_.fetch_add(1, std::memory_order_relaxed);
+            if (start > job->deadline)
+            {
+                deadlineMisses_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        else if (job->lane != DefaultLane)
+        {
+            pending_[job->lane].fetch_sub(1, std::memory_order_relaxed);
+            if (job->lane == LowLane)
+            {
+                lastLowStart_.store(start, std::memory_order_relaxed);
+            }
+        }
+
+        auto const local = currentPool_ == this;
+        auto& counters   = local ? workers_[currentIndex_]->counters[job->lane] : externalCounters_[job->lane];
+        counters.executed.fetch_add(1, std::memory_order_relaxed);
+        counters.totalWaitNs.fetch_add(wait, std::memory_order_relaxed);
+        if (wait > counters.maxWaitNs.load(std::memory_order_relaxed))
+        {
+            counters.maxWaitNs.store(wait, std::memory_order_relaxed);
+        }
+
+        job->task();
+        job->~Job();
+        SlabDeallocate(job, sizeof(Job));
+
+        auto* metrics = local ? workers_[currentIndex_]->metrics.get() : externalMetrics_.get();
+        if (metrics != nullptr)
+        {
+            metrics->wait.Record(wait);
+            metrics->run.Record(static_cast<std::uint64_t>(std::max<std::int64_t>(0, Now() - start)));
+        }
+    }
+
+    inline static thread_local ThreadPool* currentPool_ = nullptr;
+    inline static thread_local std::size_t currentIndex_ = 0;
+
     std::size_t count_;
+    std::int64_t aging_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::vector<std::size_t>> victims_;
+    std::latch started_;
     std::vector<std::thread> threads_;
-    std::vector<NotificationQueue> queues_ {count_};
+    EventCount idle_;
+    std::atomic<bool> done_ {false};
     std::atomic<std::size_t> index_ {0};
+
+    alignas(64) std::array<std::atomic<std::int64_t>, LaneCount> pending_ {};
+    std::atomic<std::int64_t> lastLowStart_ {0};
+
+    alignas(64) std::atomic<std::size_t> deadlineCount_ {0};
+    std::mutex deadlineMutex_;
+    std::vector<Job*> deadlineJobs_;
+    std::atomic<std::uint64_t> deadlineTasks_ {0};
+    std::atomic<std::uint64_t> deadlineMisses_ {0};
+
+    // Tasks run through TryRunPendingTask by threads outside the pool.
+    std::array<LaneCounters, LaneCount> externalCounters_ {};
+
+    bool metrics_;
+    std::unique_ptr<detail::WorkerMetrics> externalMetrics_;
+    alignas(64) std::array<std::atomic<std::int64_t>, LaneCount> submitted_ {};
 };
 
 template<typename Function, typename... Args>
-auto Async(Function&& f, Args&&... args)
+auto Async(TaskOptions const& options, Function&& f, Args&&... args)
 {
-    using result_type   = std::result_of_t<std::decay_t<Function>(std::decay_t<Args>...)>;
-    using packaged_type = std::packaged_task<result_type()>;
+    using result_type = std::invoke_result_t<std::decay_t<Function>, std::decay_t<Args>...>;
 
-    auto func    = [_f = std::forward<Function>(f)](Args&... ags) { return _f(std::move(ags)...); };
-    auto package = new packaged_type([=]() { return func(std::forward<Args>(args)...); });
-    auto result  = package->get_future();
+    auto promise = Promise<result_type> {};
+    auto result  = promise.get_future();
 
-    ThreadPool::GlobalInstance().Async([package] {
-        (*package)();
-        delete package;
-    });
+    ThreadPool::GlobalInstance().Async(
+        options,
+        [p = std::move(promise), func = std::forward<Function>(f), ... ags = std::forward<Args>(args)]() mutable {
+            detail::SetPromiseWith(p, func, ags...);
+        });
 
     return result;
 }
 
+template<typename Function, typename... Args>
+auto Async(QueuePriority priority, Function&& f, Args&&... args)
+{
+    return Async(TaskOptions {priority}, std::forward<Function>(f), std::forward<Args>(args)...);
+}
+
+template<typename Function, typename... Args>
+    requires std::invocable<std::decay_t<Function>, std::decay_t<Args>...>
+auto Async(Function&& f, Args&&... args)
+{
+    return Async(TaskOptions {}, std::forward<Function>(f), std::forward<Args>(args)...);
+}
+
 }  // namespace mc
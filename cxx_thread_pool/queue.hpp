@@ -1,19 +1,79 @@
 #pragma once
 
+#include "task.hpp"
+
 #include <condition_variable>
-#include <deque>
-#include <functional>
+#include <cstddef>
+#include <memory>
 #include <mutex>
+#include <utility>
 
 namespace mc
 {
 
-class NotificationQueue
+namespace detail
+{
+/**
+ * @brief Growable FIFO ring. Unlike std::deque it keeps its storage, so a
+ * queue that cycles at a steady depth stops allocating.
+ */
+template<typename T>
+class RingBuffer
+{
+public:
+    [[nodiscard]] auto empty() const noexcept -> bool { return size_ == 0; }
+    [[nodiscard]] auto size() const noexcept -> std::size_t { return size_; }
+
+    template<typename... Args>
+    auto emplace_back(Args&&... args) -> void
+    {
+        if (size_ == capacity_)
+        {
+            grow();
+        }
+
+        data_[(head_ + size_) & (capacity_ - 1)] = T(std::forward<Args>(args)...);
+        ++size_;
+    }
+
+    [[nodiscard]] auto front() noexcept -> T& { return data_[head_]; }
+
+    auto pop_front() noexcept -> void
+    {
+        data_[head_] = T {};
+        head_        = (head_ + 1) & (capacity_ - 1);
+        --size_;
+    }
+
+private:
+    auto grow() -> void
+    {
+        auto const capacity = capacity_ == 0 ? std::size_t {64} : capacity_ * 2;
+        auto data           = std::make_unique<T[]>(capacity);
+        for (std::size_t i = 0; i != size_; ++i)
+        {
+            data[i] = std::move(data_[(head_ + i) & (capacity_ - 1)]);
+        }
+
+        data_     = std::move(data);
+        capacity_ = capacity;
+        head_     = 0;
+    }
+
+    std::unique_ptr<T[]> data_;
+    std::size_t capacity_ {0};
+    std::size_t head_ {0};
+    std::size_t size_ {0};
+};
+}  // namespace detail
+
+template<typename T>
+class BasicNotificationQueue
 {
     using Lock = std::unique_lock<std::mutex>;
 
 public:
-    using value_type = std::function<void()>;
+    using value_type = T;
 
     template<typename Func>
     auto Push(Func&& func) -> void
@@ -30,7 +90,7 @@ public:
     auto TryPush(Func&& func) -> bool
     {
         {
-            Lock lock {mutex_};
+            Lock lock {mutex_, std::try_to_lock};
             if (!lock)
             {
                 return false;
@@ -61,8 +121,17 @@ public:
     }
 
     auto TryPop(value_type& x) -> bool
+    {
+        auto contended = false;
+        return TryPop(x, contended);
+    }
+
+    /// Sets contended if the queue was locked by another thread, in which
+    /// case it may or may not have been empty.
+    auto TryPop(value_type& x, bool& contended) -> bool
     {
         Lock lock {mutex_, std::try_to_lock};
+        contended = !lock;
         if (!lock || queue_.empty())
         {
             return false;
@@ -84,10 +153,12 @@ public:
     }
 
 private:
-    std::deque<value_type> queue_;
+    detail::RingBuffer<value_type> queue_;
     std::mutex mutex_;
     std::condition_variable ready_;
     bool done_ {false};
 };
 
+using NotificationQueue = BasicNotificationQueue<Task>;
+
 }  // namespace mc
\ No newline at end of file
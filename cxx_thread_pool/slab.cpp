@@ -0,0 +1,173 @@
+#include "slab.hpp"
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace mc
+{
+
+namespace
+{
+
+constexpr auto sizeClasses          = std::array<std::size_t, 4> {64, 128, 256, SlabMaxSize};
+constexpr std::size_t blocksPerChunk = 64;
+
+struct Slab;
+
+struct alignas(std::max_align_t) BlockHeader
+{
+    Slab* owner;
+    BlockHeader* next;
+};
+
+struct Slab
+{
+    std::array<BlockHeader*, sizeClasses.size()> local {};
+    std::array<std::atomic<BlockHeader*>, sizeClasses.size()> remote {};
+};
+
+// Slabs and their registry are never destroyed, blocks may outlive the
+// thread that allocated them and are still freed during static destruction.
+auto orphanMutex() -> std::mutex&
+{
+    static auto* mutex = new std::mutex {};
+    return *mutex;
+}
+
+auto orphans() -> std::vector<Slab*>&
+{
+    static auto* slabs = new std::vector<Slab*> {};
+    return *slabs;
+}
+
+auto adoptSlab() -> Slab*
+{
+    auto lock = std::scoped_lock {orphanMutex()};
+    if (orphans().empty())
+    {
+        return new Slab {};
+    }
+
+    auto* slab = orphans().back();
+    orphans().pop_back();
+    return slab;
+}
+
+auto retireSlab(Slab* slab) -> void
+{
+    auto lock = std::scoped_lock {orphanMutex()};
+    orphans().push_back(slab);
+}
+
+thread_local Slab* currentSlab = nullptr;
+thread_local bool retired      = false;
+
+struct SlabRetirement
+{
+    ~SlabRetirement()
+    {
+        retireSlab(currentSlab);
+        currentSlab = nullptr;
+        retired     = true;
+    }
+};
+
+thread_local SlabRetirement retirement;
+
+auto localSlab() -> Slab&
+{
+    if (currentSlab == nullptr)
+    {
+        currentSlab = adoptSlab();
+
+        // Allocating during thread teardown keeps the slab for good.
+        if (!retired)
+        {
+            static_cast<void>(&retirement);
+        }
+    }
+
+    return *currentSlab;
+}
+
+constexpr auto sizeClassIndex(std::size_t size) noexcept -> std::size_t
+{
+    auto i = std::size_t {0};
+    while (sizeClasses[i] < size)
+    {
+        ++i;
+    }
+    return i;
+}
+
+auto refill(Slab& slab, std::size_t cls) -> BlockHeader*
+{
+    auto const stride = sizeof(BlockHeader) + sizeClasses[cls];
+    auto* chunk       = static_cast<std::byte*>(::operator new(stride * blocksPerChunk));
+
+    BlockHeader* head = nullptr;
+    for (auto i = blocksPerChunk; i != 0; --i)
+    {
+        auto* block = ::new (chunk + (i - 1) * stride) BlockHeader {&slab, head};
+        head        = block;
+    }
+    return head;
+}
+
+}  // namespace
+
+auto SlabAllocate(std::size_t size) -> void*
+{
+    if (size > SlabMaxSize)
+    {
+        return ::operator new(size);
+    }
+
+    auto const cls = sizeClassIndex(size);
+    auto& slab     = localSlab();
+
+    auto* block = slab.local[cls];
+    if (block == nullptr)
+    {
+        block = slab.remote[cls].exchange(nullptr, std::memory_order_acquire);
+    }
+    if (block == nullptr)
+    {
+        block = refill(slab, cls);
+    }
+
+    slab.local[cls] = block->next;
+    return block + 1;
+}
+
+auto SlabDeallocate(void* ptr, std::size_t size) noexcept -> void
+{
+    if (size > SlabMaxSize)
+    {
+        ::operator delete(ptr);
+        return;
+    }
+
+    auto const cls = sizeClassIndex(size);
+    auto* block    = static_cast<BlockHeader*>(ptr) - 1;
+    auto* owner    = block->owner;
+
+    if (owner == currentSlab)
+    {
+        block->next       = owner->local[cls];
+        owner->local[cls] = block;
+        return;
+    }
+
+    auto& remote = owner->remote[cls];
+    auto* head   = remote.load(std::memory_order_relaxed);
+    do
+    {
+        block->next = head;
+    } while (!remote.compare_exchange_weak(head, block, std::memory_order_release, std::memory_order_relaxed));
+}
+
+}  // namespace mc
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+
+namespace mc
+{
+
+/**
+ * @brief Fixed size-class allocator backed by per-thread free lists.
+ *
+ * Blocks freed on the allocating thread go straight back to its local list,
+ * blocks freed elsewhere are handed back through a lock-free remote list. Once
+ * the lists are warm, allocating and freeing never call malloc. Memory is
+ * recycled but never returned to the system; the slab of an exiting thread
+ * is adopted by the next thread that starts.
+ *
+ * Requests above SlabMaxSize are forwarded to the global operator new.
+ */
+inline constexpr std::size_t SlabMaxSize = 512;
+
+[[nodiscard]] auto SlabAllocate(std::size_t size) -> void*;
+auto SlabDeallocate(void* ptr, std::size_t size) noexcept -> void;
+
+}  // namespace mc
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace mc
+{
+
+/**
+ * @brief Move-only `void()` callable with inline storage.
+ *
+ * Closures up to InlineSize bytes that are nothrow move constructible are
+ * stored in place, everything else falls back to the heap.
+ */
+class Task
+{
+public:
+    static constexpr std::size_t InlineSize = 64;
+
+    Task() noexcept = default;
+
+    template<typename Func>
+        requires(!std::is_same_v<std::decay_t<Func>, Task> && std::is_invocable_v<std::decay_t<Func>&>)
+    Task(Func&& func)
+    {
+        using Stored = std::decay_t<Func>;
+        if constexpr (storedInline<Stored>)
+        {
+            ::new (static_cast<void*>(&storage_)) Stored(std::forward<Func>(func));
+            vtable_ = &inlineVTable<Stored>;
+        }
+        else
+        {
+            ::new (static_cast<void*>(&storage_)) Stored*(new Stored(std::forward<Func>(func)));
+            vtable_ = &heapVTable<Stored>;
+        }
+    }
+
+    Task(Task const&) = delete;
+    Task(Task&& other) noexcept : vtable_ {std::exchange(other.vtable_, nullptr)}
+    {
+        if (vtable_ != nullptr)
+        {
+            vtable_->move(&storage_, &other.storage_);
+        }
+    }
+
+    auto operator=(Task const&) -> Task& = delete;
+    auto operator=(Task&& other) noexcept -> Task&
+    {
+        if (this != &other)
+        {
+            reset();
+            vtable_ = std::exchange(other.vtable_, nullptr);
+            if (vtable_ != nullptr)
+            {
+                vtable_->move(&storage_, &other.storage_);
+            }
+        }
+        return *this;
+    }
+
+    ~Task() noexcept { reset(); }
+
+    explicit operator bool() const noexcept { return vtable_ != nullptr; }
+
+    auto operator()() -> void { vtable_->invoke(&storage_); }
+
+private:
+    struct VTable
+    {
+        void (*invoke)(void*);
+        void (*move)(void* dst, void* src) noexcept;
+        void (*destroy)(void*) noexcept;
+    };
+
+    template<typename Stored>
+    static constexpr bool storedInline = sizeof(Stored) <= InlineSize
+                                      && alignof(Stored) <= alignof(std::max_align_t)
+                                      && std::is_nothrow_move_constructible_v<Stored>;
+
+    template<typename Stored>
+    static constexpr VTable inlineVTable {
+        [](void* p) { std::invoke(*static_cast<Stored*>(p)); },
+        [](void* dst, void* src) noexcept {
+            ::new (dst) Stored(std::move(*static_cast<Stored*>(src)));
+            static_cast<Stored*>(src)->~Stored();
+        },
+        [](void* p) noexcept { static_cast<Stored*>(p)->~Stored(); },
+    };
+
+    template<typename Stored>
+    static constexpr VTable heapVTable {
+        [](void* p) { std::invoke(**static_cast<Stored**>(p)); },
+        [](void* dst, void* src) noexcept { ::new (dst) Stored*(*static_cast<Stored**>(src)); },
+        [](void* p) noexcept { delete *static_cast<Stored**>(p); },
+    };
+
+    auto reset() noexcept -> void
+    {
+        if (vtable_ != nullptr)
+        {
+            std::exchange(vtable_, nullptr)->destroy(&storage_);
+        }
+    }
+
+    alignas(std::max_align_t) std::byte storage_[InlineSize] {};
+    VTable const* vtable_ {nullptr};
+};
+
+}  // namespace mc
@@ -1,8 +1,8 @@
 #pragma once
 
-#include <sys/time.h>
+#include "trace.hpp"
 
-#include <cmath>
+#include <cstdint>
 #include <cstdio>
 
 #include <string>
@@ -10,10 +10,19 @@
 
 namespace mc
 {
+/**
+ * @brief Prints the time spent in its scope, and records it as a trace
+ * event while a TraceSession is active.
+ */
 class ScopedTimer
 {
 public:
-    explicit ScopedTimer(std::string name) : name_ {std::move(name)} { gettimeofday(&startTime_, nullptr); }
+    explicit ScopedTimer(std::string name)
+        : name_ {std::move(name)}
+        , traceName_ {Tracer::Enabled() ? Tracer::Intern(name_) : nullptr}
+        , start_ {TraceClock::StartTick()}
+    {
+    }
 
     ScopedTimer(ScopedTimer const&) noexcept = default;
     ScopedTimer(ScopedTimer&&) noexcept      = default;
@@ -23,15 +32,17 @@ public:
 
     ~ScopedTimer()
     {
-        timeval stopTime {};
-        gettimeofday(&stopTime, nullptr);
-        auto const elapsedSec = static_cast<double>(stopTime.tv_sec - startTime_.tv_sec) * 1000.0;
-        auto const elapsedMs  = static_cast<double>(stopTime.tv_usec - startTime_.tv_usec) / 1000.0;
-        printf("%s: %.4f ms\n", name_.c_str(), elapsedSec + elapsedMs);
+        auto const stop = TraceClock::Now();
+        if (traceName_ != nullptr)
+        {
+            Tracer::Record(traceName_, start_, stop);
+        }
+        printf("%s: %.4f ms\n", name_.c_str(), TraceClock::ToNanoseconds(stop - start_) / 1'000'000.0);
     }
 
 private:
-    timeval startTime_ {};
     std::string name_;
+    char const* traceName_;
+    std::uint64_t start_;
 };
 }  // namespace mc
@@ -0,0 +1,360 @@
+#include "topology.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <string>
+#include <tuple>
+
+namespace mc
+{
+
+namespace
+{
+
+auto Trim(std::string s) -> std::string
+{
+    auto isNotSpace = [](unsigned char ch) { return std::isspace(ch) == 0; };
+    s.erase(s.begin(), std::find_if(s.begin(), s.end(), isNotSpace));
+    s.erase(std::find_if(s.rbegin(), s.rend(), isNotSpace).base(), s.end());
+    return s;
+}
+
+auto ReadFirstLine(std::string const& path) -> std::optional<std::string>
+{
+    auto in   = std::ifstream {path};
+    auto line = std::string {};
+    if (!in.is_open() || !std::getline(in, line))
+    {
+        return std::nullopt;
+    }
+    return Trim(line);
+}
+
+auto ReadUnsigned(std::string const& path) -> std::optional<unsigned>
+{
+    auto const line = ReadFirstLine(path);
+    if (!line || line->empty())
+    {
+        return std::nullopt;
+    }
+
+    try
+    {
+        return static_cast<unsigned>(std::stoul(*line));
+    }
+    catch (...)
+    {
+        return std::nullopt;
+    }
+}
+
+// Kernel cpulist format, e.g. "0-3,8-11".
+auto ParseCpuList(std::string const& list) -> std::set<unsigned>
+{
+    auto cpus  = std::set<unsigned> {};
+    auto in    = std::istringstream {list};
+    auto range = std::string {};
+    while (std::getline(in, range, ','))
+    {
+        range = Trim(range);
+        if (range.empty())
+        {
+            continue;
+        }
+
+        try
+        {
+            auto const dash  = range.find('-');
+            auto const first = static_cast<unsigned>(std::stoul(range.substr(0, dash)));
+            auto const last
+                = dash == std::string::npos ? first : static_cast<unsigned>(std::stoul(range.substr(dash + 1)));
+            for (auto cpu = first; cpu <= last; ++cpu)
+            {
+                cpus.insert(cpu);
+            }
+        }
+        catch (...)
+        {
+            return {};
+        }
+    }
+    return cpus;
+}
+
+auto AffinityMask() -> std::set<unsigned>
+{
+    auto cpus = std::set<unsigned> {};
+    for (auto size = 1024; size <= 1 << 16; size *= 2)
+    {
+        auto* set = CPU_ALLOC(size);
+        if (set == nullptr)
+        {
+            break;
+        }
+        auto const bytes = CPU_ALLOC_SIZE(size);
+        CPU_ZERO_S(bytes, set);
+
+        if (sched_getaffinity(0, bytes, set) == 0)
+        {
+            for (auto cpu = 0; cpu < size; ++cpu)
+            {
+                if (CPU_ISSET_S(cpu, bytes, set))
+                {
+                    cpus.insert(static_cast<unsigned>(cpu));
+                }
+            }
+            CPU_FREE(set);
+            return cpus;
+        }
+
+        CPU_FREE(set);
+        if (errno != EINVAL)
+        {
+            break;
+        }
+    }
+    return cpus;
+}
+
+// "physical id" and "core id" per "processor", same key/value parsing as
+// cxx_linux_proc_info.
+auto ProcCpuInfo() -> std::map<unsigned, CpuInfo>
+{
+    auto result  = std::map<unsigned, CpuInfo> {};
+    auto in      = std::ifstream {"/proc/cpuinfo"};
+    auto line    = std::string {};
+    auto current = std::optional<unsigned> {};
+
+    while (std::getline(in, line))
+    {
+        auto const colon = line.find(':');
+        if (colon == std::string::npos)
+        {
+            continue;
+        }
+
+        auto const key   = Trim(line.substr(0, colon));
+        auto const value = Trim(line.substr(colon + 1));
+
+        try
+        {
+            if (key == "processor")
+            {
+                current = static_cast<unsigned>(std::stoul(value));
+                result[*current].id = *current;
+            }
+            else if (current && key == "physical id")
+            {
+                result[*current].package = static_cast<unsigned>(std::stoul(value));
+            }
+            else if (current && key == "core id")
+            {
+                result[*current].core = static_cast<unsigned>(std::stoul(value));
+            }
+        }
+        catch (...)
+        {
+            continue;
+        }
+    }
+    return result;
+}
+
+// CPU quota of our cgroup, from the v2 unified hierarchy or the v1 cpu controller.
+auto CgroupQuota() -> double
+{
+    auto in   = std::ifstream {"/proc/self/cgroup"};
+    auto line = std::string {};
+    auto v1   = std::optional<std::string> {};
+    auto v2   = std::optional<std::string> {};
+
+    while (std::getline(in, line))
+    {
+        auto const first  = line.find(':');
+        auto const second = line.find(':', first + 1);
+        if (first == std::string::npos || second == std::string::npos)
+        {
+            continue;
+        }
+
+        auto controllers = std::string {","};
+        controllers.append(line, first + 1, second - first - 1).push_back(',');
+        auto const path        = line.substr(second + 1);
+        if (controllers == ",,")
+        {
+            v2 = path;
+        }
+        else if (controllers.find(",cpu,") != std::string::npos)
+        {
+            v1 = path;
+        }
+    }
+
+    // cpu.max: "<quota|max> <period>"
+    for (auto const& dir : {v2.value_or("/"), std::string {"/"}})
+    {
+        if (auto const max = ReadFirstLine("/sys/fs/cgroup" + dir + "/cpu.max"); max)
+        {
+            auto fields = std::istringstream {*max};
+            auto quota  = std::string {};
+            auto period = 0.0;
+            if (!(fields >> quota >> period) || quota == "max" || period <= 0.0)
+            {
+                return 0.0;
+            }
+
+            try
+            {
+                auto const q = std::stod(quota);
+                return q > 0.0 ? q / period : 0.0;
+            }
+            catch (...)
+            {
+                return 0.0;
+            }
+        }
+    }
+
+    for (auto const* mount : {"/sys/fs/cgroup/cpu,cpuacct", "/sys/fs/cgroup/cpu"})
+    {
+        for (auto const& dir : {v1.value_or("/"), std::string {"/"}})
+        {
+            auto const base   = std::string {mount} + dir;
+            auto const quota  = ReadFirstLine(base + "/cpu.cfs_quota_us");
+            auto const period = ReadFirstLine(base + "/cpu.cfs_period_us");
+            if (!quota || !period)
+            {
+                continue;
+            }
+
+            try
+            {
+                auto const q = std::stod(*quota);
+                auto const p = std::stod(*period);
+                return q > 0.0 && p > 0.0 ? q / p : 0.0;
+            }
+            catch (...)
+            {
+                return 0.0;
+            }
+        }
+    }
+
+    return 0.0;
+}
+
+}  // namespace
+
+auto Topology::ThreadCount() const noexcept -> std::size_t
+{
+    auto count = std::max<std::size_t>(1, cpus.size());
+    if (quota > 0.0)
+    {
+        count = std::min(count, static_cast<std::size_t>(std::ceil(quota)));
+    }
+    return std::max<std::size_t>(1, count);
+}
+
+auto DiscoverTopology() -> Topology
+{
+    auto usable = AffinityMask();
+    if (auto const online = ReadFirstLine("/sys/devices/system/cpu/online"); online)
+    {
+        auto const onlineCpus = ParseCpuList(*online);
+        if (!onlineCpus.empty() && !usable.empty())
+        {
+            std::erase_if(usable, [&](auto cpu) { return !onlineCpus.contains(cpu); });
+        }
+        else if (usable.empty())
+        {
+            usable = onlineCpus;
+        }
+    }
+
+    auto const procInfo = ProcCpuInfo();
+    if (usable.empty())
+    {
+        for (auto const& [id, info] : procInfo)
+        {
+            usable.insert(id);
+        }
+    }
+
+    auto topology = Topology {};
+    for (auto const id : usable)
+    {
+        auto const dir = "/sys/devices/system/cpu/cpu" + std::to_string(id) + "/topology/";
+        auto cpu       = CpuInfo {id, id, 0, 0};
+
+        if (auto const found = procInfo.find(id); found != procInfo.end())
+        {
+            cpu.core    = found->second.core;
+            cpu.package = found->second.package;
+        }
+
+        cpu.core    = ReadUnsigned(dir + "core_id").value_or(cpu.core);
+        cpu.package = ReadUnsigned(dir + "physical_package_id").value_or(cpu.package);
+        topology.cpus.push_back(cpu);
+    }
+
+    auto const nodes = ParseCpuList(ReadFirstLine("/sys/devices/system/node/online").value_or(""));
+    for (auto const node : nodes)
+    {
+        auto const list = ReadFirstLine("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        for (auto const id : ParseCpuList(list.value_or("")))
+        {
+            auto const found = std::find_if(topology.cpus.begin(), topology.cpus.end(), [id](auto const& cpu) {
+                return cpu.id == id;
+            });
+            if (found != topology.cpus.end())
+            {
+                found->node = node;
+            }
+        }
+    }
+
+    // Number SMT siblings of a core 0, 1, ... and put all the 0s first.
+    auto sibling  = std::map<std::tuple<unsigned, unsigned, unsigned>, unsigned> {};
+    auto smtIndex = std::map<unsigned, unsigned> {};
+    for (auto const& cpu : topology.cpus)
+    {
+        smtIndex[cpu.id] = sibling[{cpu.node, cpu.package, cpu.core}]++;
+    }
+
+    std::stable_sort(topology.cpus.begin(), topology.cpus.end(), [&](auto const& lhs, auto const& rhs) {
+        return std::tuple {lhs.node, smtIndex[lhs.id], lhs.package, lhs.core}
+             < std::tuple {rhs.node, smtIndex[rhs.id], rhs.package, rhs.core};
+    });
+
+    topology.nodes = std::max<std::size_t>(1, nodes.size());
+    topology.quota = CgroupQuota();
+    return topology;
+}
+
+auto PinCurrentThread(unsigned cpu) noexcept -> bool
+{
+    auto const size  = static_cast<int>(std::max(cpu + 1U, 1024U));
+    auto* set        = CPU_ALLOC(size);
+    if (set == nullptr)
+    {
+        return false;
+    }
+    auto const bytes = CPU_ALLOC_SIZE(size);
+    CPU_ZERO_S(bytes, set);
+    CPU_SET_S(cpu, bytes, set);
+    auto const result = pthread_setaffinity_np(pthread_self(), bytes, set);
+    CPU_FREE(set);
+    return result == 0;
+}
+
+}  // namespace mc
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace mc
+{
+
+struct CpuInfo
+{
+    unsigned id {0};
+    unsigned core {0};
+    unsigned package {0};
+    unsigned node {0};
+};
+
+/**
+ * @brief CPUs this process may run on, as seen by Linux.
+ *
+ * Built from /sys/devices/system/cpu and /sys/devices/system/node, falling
+ * back to /proc/cpuinfo for package and core ids. Only CPUs that are online
+ * and in the affinity mask are listed. They are ordered node by node, with the
+ * first hardware thread of every core ahead of its SMT siblings, so a prefix
+ * of the list is a good placement for fewer threads than CPUs.
+ */
+struct Topology
+{
+    std::vector<CpuInfo> cpus;
+    std::size_t nodes {1};
+
+    /// CPU bandwidth granted by the cgroup in CPUs, 0 when unlimited.
+    double quota {0.0};
+
+    /// Usable CPUs, capped by the cgroup quota, at least 1.
+    [[nodiscard]] auto ThreadCount() const noexcept -> std::size_t;
+};
+
+[[nodiscard]] auto DiscoverTopology() -> Topology;
+
+/// Restrict the calling thread to a single CPU. Returns false on failure.
+auto PinCurrentThread(unsigned cpu) noexcept -> bool;
+
+}  // namespace mc
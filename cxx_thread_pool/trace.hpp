@@ -0,0 +1,443 @@
+#pragma once
+
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace mc
+{
+
+/**
+ * @brief Raw timestamps for tracing: the TSC on x86, CLOCK_MONOTONIC_RAW
+ * elsewhere. Ticks are converted to nanoseconds off the hot path.
+ */
+struct TraceClock
+{
+    [[nodiscard]] static auto Now() noexcept -> std::uint64_t
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return MonotonicRawNs();
+#endif
+    }
+
+    [[nodiscard]] static auto MonotonicRawNs() noexcept -> std::uint64_t
+    {
+        auto ts = timespec {};
+        clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+        return static_cast<std::uint64_t>(ts.tv_sec) * 1'000'000'000U + static_cast<std::uint64_t>(ts.tv_nsec);
+    }
+
+    /// Measured once against CLOCK_MONOTONIC_RAW, which takes about 2 ms.
+    [[nodiscard]] static auto NanosecondsPerTick() -> double
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        static auto const factor = [] {
+            auto const ns0  = MonotonicRawNs();
+            auto const tsc0 = Now();
+            auto ns1        = ns0;
+            while (ns1 - ns0 < 2'000'000)
+            {
+                ns1 = MonotonicRawNs();
+            }
+            auto const tsc1 = Now();
+            return static_cast<double>(ns1 - ns0) / static_cast<double>(tsc1 - tsc0);
+        }();
+        return factor;
+#else
+        return 1.0;
+#endif
+    }
+
+    /// Now() for the start of a measured scope. Calibrates first, so that
+    /// the first ToNanoseconds never busy-waits inside the scope.
+    [[nodiscard]] static auto StartTick() -> std::uint64_t
+    {
+        static_cast<void>(NanosecondsPerTick());
+        return Now();
+    }
+
+    [[nodiscard]] static auto ToNanoseconds(std::uint64_t ticks) -> double
+    {
+        return static_cast<double>(ticks) * NanosecondsPerTick();
+    }
+};
+
+namespace detail
+{
+
+struct TraceEvent
+{
+    char const* name;
+    std::uint64_t begin;
+    std::uint64_t end;
+};
+
+// Single producer (the owning thread), single consumer (the flusher). A
+// full ring drops the event and counts it, the producer never waits.
+class TraceRing
+{
+public:
+    static constexpr std::size_t Capacity = std::size_t {1} << 13U;
+
+    explicit TraceRing(std::uint32_t tid) : tid_ {tid} { }
+
+    auto Push(TraceEvent const& event) noexcept -> void
+    {
+        auto const head = head_.load(std::memory_order_relaxed);
+        if (head - cachedTail_ == Capacity)
+        {
+            cachedTail_ = tail_.load(std::memory_order_acquire);
+            if (head - cachedTail_ == Capacity)
+            {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+
+        events_[head & (Capacity - 1)] = event;
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    template<typename Func>
+    auto Drain(Func&& func) -> void
+    {
+        auto tail       = tail_.load(std::memory_order_relaxed);
+        auto const head = head_.load(std::memory_order_acquire);
+        for (; tail != head; ++tail)
+        {
+            func(events_[tail & (Capacity - 1)]);
+        }
+        tail_.store(tail, std::memory_order_release);
+    }
+
+    [[nodiscard]] auto Tid() const noexcept -> std::uint32_t { return tid_; }
+
+    [[nodiscard]] auto Dropped() const noexcept -> std::uint64_t { return dropped_.load(std::memory_order_relaxed); }
+
+    [[nodiscard]] auto Retired() const noexcept -> bool { return retired_.load(std::memory_order_acquire); }
+
+    auto Retire() noexcept -> void { retired_.store(true, std::memory_order_release); }
+
+private:
+    std::uint32_t tid_;
+    std::atomic<bool> retired_ {false};
+    std::atomic<std::uint64_t> dropped_ {0};
+
+    alignas(64) std::atomic<std::size_t> head_ {0};
+    std::size_t cachedTail_ {0};
+
+    alignas(64) std::atomic<std::size_t> tail_ {0};
+
+    alignas(64) std::array<TraceEvent, Capacity> events_;
+};
+
+// Every thread that ever recorded an event. Rings are shared with the
+// flusher, so events of a thread that already exited are still written.
+class TraceRegistry
+{
+public:
+    [[nodiscard]] static auto GlobalInstance() -> TraceRegistry&
+    {
+        static auto registry = TraceRegistry {};
+        return registry;
+    }
+
+    [[nodiscard]] static auto CurrentRing() -> TraceRing*
+    {
+        if (current_ == nullptr)
+        {
+            // First event of this thread, allocate and register its ring.
+            static thread_local auto const owner = Owner {GlobalInstance().add()};
+            current_                             = owner.ring.get();
+        }
+        return current_;
+    }
+
+    [[nodiscard]] auto Snapshot() -> std::vector<std::shared_ptr<TraceRing>>
+    {
+        auto lock = std::scoped_lock {mutex_};
+        return rings_;
+    }
+
+    // Forgets rings of exited threads. Only pass rings that were already
+    // retired before their last drain started: a thread that exits while its
+    // ring is drained may have recorded events the drain did not see.
+    auto Prune(std::vector<std::shared_ptr<TraceRing>> const& retired) -> void
+    {
+        auto lock = std::scoped_lock {mutex_};
+        for (auto const& ring : retired)
+        {
+            droppedByRetired_ += ring->Dropped();
+            std::erase(rings_, ring);
+        }
+    }
+
+    [[nodiscard]] auto Dropped() -> std::uint64_t
+    {
+        auto lock    = std::scoped_lock {mutex_};
+        auto dropped = droppedByRetired_;
+        for (auto const& ring : rings_)
+        {
+            dropped += ring->Dropped();
+        }
+        return dropped;
+    }
+
+private:
+    // Retires the ring when its thread exits. Recording from other
+    // thread_local destructors after that is not supported.
+    struct Owner
+    {
+        explicit Owner(std::shared_ptr<TraceRing> r) : ring {std::move(r)} { }
+
+        Owner(Owner const&)                    = delete;
+        auto operator=(Owner const&) -> Owner& = delete;
+
+        ~Owner() { ring->Retire(); }
+
+        std::shared_ptr<TraceRing> ring;
+    };
+
+    auto add() -> std::shared_ptr<TraceRing>
+    {
+        auto lock = std::scoped_lock {mutex_};
+        auto ring = std::make_shared<TraceRing>(nextTid_++);
+        rings_.push_back(ring);
+        return ring;
+    }
+
+    static inline thread_local TraceRing* current_ {nullptr};
+
+    std::mutex mutex_;
+    std::vector<std::shared_ptr<TraceRing>> rings_;
+    std::uint32_t nextTid_ {1};
+    std::uint64_t droppedByRetired_ {0};
+};
+
+}  // namespace detail
+
+/**
+ * @brief Process wide switch and hot path of the tracer.
+ *
+ * Record() only takes two timestamps and a name pointer and copies them into
+ * the calling thread's ring. Names must outlive the trace session: string
+ * literals, or strings from Intern(). While no TraceSession is active,
+ * instrumented scopes cost a relaxed load and a branch.
+ */
+class Tracer
+{
+public:
+    [[nodiscard]] static auto Enabled() noexcept -> bool { return enabled_.load(std::memory_order_relaxed); }
+
+    static auto Record(char const* name, std::uint64_t begin, std::uint64_t end) -> void
+    {
+        detail::TraceRegistry::CurrentRing()->Push(detail::TraceEvent {name, begin, end});
+    }
+
+    /// Stable copy of a runtime string, for names that are not literals.
+    [[nodiscard]] static auto Intern(std::string_view name) -> char const*
+    {
+        static auto mutex = std::mutex {};
+        static auto names = std::unordered_set<std::string> {};
+
+        auto lock = std::scoped_lock {mutex};
+        return names.emplace(name).first->c_str();
+    }
+
+private:
+    friend class TraceSession;
+
+    static inline std::atomic<bool> enabled_ {false};
+};
+
+/**
+ * @brief Records one complete event for the lifetime of the scope.
+ */
+class TraceScope
+{
+public:
+    explicit TraceScope(char const* name) noexcept : name_ {Tracer::Enabled() ? name : nullptr}
+    {
+        if (name_ != nullptr)
+        {
+            begin_ = TraceClock::Now();
+        }
+    }
+
+    TraceScope(TraceScope const&)                    = delete;
+    auto operator=(TraceScope const&) -> TraceScope& = delete;
+
+    ~TraceScope()
+    {
+        if (name_ != nullptr)
+        {
+            Tracer::Record(name_, begin_, TraceClock::Now());
+        }
+    }
+
+private:
+    char const* name_;
+    std::uint64_t begin_ {0};
+};
+
+#define MC_TRACE_CONCAT_IMPL(a, b) a##b
+#define MC_TRACE_CONCAT(a, b) MC_TRACE_CONCAT_IMPL(a, b)
+
+/// Traces the enclosing scope under name, which must be a string literal.
+#define MC_TRACE_SCOPE(name) ::mc::TraceScope MC_TRACE_CONCAT(mcTraceScope, __LINE__) { name }
+
+/**
+ * @brief Enables tracing and writes all events to a Chrome/Perfetto JSON
+ * trace file until destroyed.
+ *
+ * A background thread drains the per-thread rings every interval, all
+ * formatting and file I/O happens there. One session at a time. A null path
+ * gives an inactive session, handy for optional tracing from an environment
+ * variable. Events that did not fit into a ring are counted in otherData.
+ */
+class TraceSession
+{
+public:
+    explicit TraceSession(char const* path, std::chrono::milliseconds interval = std::chrono::milliseconds {20})
+        : file_ {path != nullptr ? std::fopen(path, "w") : nullptr}, interval_ {interval}
+    {
+        if (file_ == nullptr)
+        {
+            if (path != nullptr)
+            {
+                std::perror(path);
+            }
+            return;
+        }
+
+        nsPerTick_ = TraceClock::NanosecondsPerTick();
+        start_     = TraceClock::Now();
+        std::fputs("{\"traceEvents\":[\n", file_);
+        flusher_ = std::thread {[this] { run(); }};
+        Tracer::enabled_.store(true, std::memory_order_relaxed);
+    }
+
+    TraceSession(TraceSession const&)                    = delete;
+    auto operator=(TraceSession const&) -> TraceSession& = delete;
+
+    ~TraceSession()
+    {
+        if (file_ == nullptr)
+        {
+            return;
+        }
+
+        Tracer::enabled_.store(false, std::memory_order_relaxed);
+        {
+            auto lock = std::scoped_lock {mutex_};
+            stop_     = true;
+        }
+        wakeup_.notify_one();
+        flusher_.join();
+
+        std::fprintf(file_, "\n],\"displayTimeUnit\":\"ns\",\"otherData\":{\"dropped_events\":\"%llu\"}}\n",
+                     static_cast<unsigned long long>(detail::TraceRegistry::GlobalInstance().Dropped()));
+        std::fclose(file_);
+    }
+
+    [[nodiscard]] auto Active() const noexcept -> bool { return file_ != nullptr; }
+
+private:
+    auto run() -> void
+    {
+        auto lock = std::unique_lock {mutex_};
+        while (!stop_)
+        {
+            wakeup_.wait_for(lock, interval_);
+            lock.unlock();
+            flush();
+            lock.lock();
+        }
+        lock.unlock();
+
+        // Scopes that were open when tracing stopped still record their end.
+        flush();
+    }
+
+    auto flush() -> void
+    {
+        auto& registry = detail::TraceRegistry::GlobalInstance();
+        auto retired   = std::vector<std::shared_ptr<detail::TraceRing>> {};
+        for (auto const& ring : registry.Snapshot())
+        {
+            // Retire is the last thing a thread does with its ring, so if it
+            // is seen here the drain below gets every event.
+            auto const wasRetired = ring->Retired();
+            ring->Drain([this, tid = ring->Tid()](detail::TraceEvent const& event) { write(tid, event); });
+            if (wasRetired)
+            {
+                retired.push_back(ring);
+            }
+        }
+        registry.Prune(retired);
+        std::fflush(file_);
+    }
+
+    auto write(std::uint32_t tid, detail::TraceEvent const& event) -> void
+    {
+        // Scopes that began before the session started are clipped to it.
+        auto const begin = std::max(event.begin, start_);
+        auto const end   = std::max(event.end, begin);
+        auto const ts    = static_cast<double>(begin - start_) * nsPerTick_ / 1000.0;
+        auto const dur   = static_cast<double>(end - begin) * nsPerTick_ / 1000.0;
+
+        std::fputs(first_ ? "" : ",\n", file_);
+        first_ = false;
+        std::fputs("{\"name\":\"", file_);
+        // Same escaping as detail::WriteJsonString in cxx_benchmark.
+        for (auto const* c = event.name; *c != '\0'; ++c)
+        {
+            if (*c == '"' || *c == '\\')
+            {
+                std::fprintf(file_, "\\%c", *c);
+            }
+            else if (static_cast<unsigned char>(*c) < 0x20)
+            {
+                std::fprintf(file_, "\\u%04x", static_cast<unsigned>(*c));
+            }
+            else
+            {
+                std::fputc(*c, file_);
+            }
+        }
+        std::fprintf(file_, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", tid, ts, dur);
+    }
+
+    std::FILE* file_;
+    std::chrono::milliseconds interval_;
+    double nsPerTick_ {1.0};
+    std::uint64_t start_ {0};
+    bool first_ {true};
+
+    std::mutex mutex_;
+    std::condition_variable wakeup_;
+    bool stop_ {false};
+    std::thread flusher_;
+};
+
+}  // namespace mc
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace mc
+{
+
+/**
+ * @brief Chase-Lev work-stealing deque.
+ *
+ * The owning thread pushes and pops at the bottom (LIFO), any other thread may
+ * steal from the top (FIFO). Memory orderings follow "Correct and Efficient
+ * Work-Stealing for Weak Memory Models" (Le, Pop, Cohen, Zappa Nardelli 2013),
+ * with the seq_cst fences folded into the neighbouring atomics.
+ * Retired arrays are kept alive until the deque is destroyed, because a thief
+ * may still be reading from them.
+ */
+template<typename T>
+class WorkStealingDeque
+{
+    static_assert(std::is_trivially_copyable_v<T>, "elements must be trivially copyable, e.g. pointers");
+
+    struct Array
+    {
+        explicit Array(std::int64_t cap) : capacity {cap}, mask {cap - 1}, data {new std::atomic<T>[cap]}
+        {
+            assert(cap > 0 && (cap & (cap - 1)) == 0);
+        }
+
+        auto Put(std::int64_t i, T x) noexcept -> void { data[i & mask].store(x, std::memory_order_relaxed); }
+        [[nodiscard]] auto Get(std::int64_t i) const noexcept -> T
+        {
+            return data[i & mask].load(std::memory_order_relaxed);
+        }
+
+        std::int64_t capacity;
+        std::int64_t mask;
+        std::unique_ptr<std::atomic<T>[]> data;
+    };
+
+public:
+    explicit WorkStealingDeque(std::int64_t capacity = 1024)
+    {
+        auto initial = std::make_unique<Array>(capacity);
+        array_.store(initial.get(), std::memory_order_relaxed);
+        arrays_.push_back(std::move(initial));
+    }
+
+    WorkStealingDeque(WorkStealingDeque const&) = delete;
+    WorkStealingDeque(WorkStealingDeque&&)      = delete;
+
+    auto operator=(WorkStealingDeque const&) -> WorkStealingDeque& = delete;
+    auto operator=(WorkStealingDeque&&) -> WorkStealingDeque& = delete;
+
+    ~WorkStealingDeque() = default;
+
+    /// Owner only.
+    auto Push(T x) -> void
+    {
+        auto const b = bottom_.load(std::memory_order_relaxed);
+        auto const t = top_.load(std::memory_order_acquire);
+        auto* a      = array_.load(std::memory_order_relaxed);
+
+        if (b - t > a->capacity - 1)
+        {
+            a = Grow(a, t, b);
+        }
+
+        a->Put(b, x);
+        bottom_.store(b + 1, std::memory_order_release);
+    }
+
+    /// Owner only.
+    auto Pop(T& x) -> bool
+    {
+        auto const b = bottom_.load(std::memory_order_relaxed) - 1;
+        auto* a      = array_.load(std::memory_order_relaxed);
+        bottom_.exchange(b, std::memory_order_seq_cst);
+        auto t = top_.load(std::memory_order_seq_cst);
+
+        if (t > b)
+        {
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        x = a->Get(b);
+        if (t == b)
+        {
+            // Last element, race against thieves.
+            auto const won
+                = top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+
+        return true;
+    }
+
+    /// Any thread. Retries lost races while the deque is non-empty.
+    auto Steal(T& x) -> bool
+    {
+        while (true)
+        {
+            auto t       = top_.load(std::memory_order_seq_cst);
+            auto const b = bottom_.load(std::memory_order_seq_cst);
+
+            if (t >= b)
+            {
+                return false;
+            }
+
+            auto* a    = array_.load(std::memory_order_acquire);
+            auto value = a->Get(t);
+            if (top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            {
+                x = value;
+                return true;
+            }
+        }
+    }
+
+    /// Approximate, may be stale by the time it returns.
+    [[nodiscard]] auto Size() const noexcept -> std::int64_t
+    {
+        auto const b = bottom_.load(std::memory_order_relaxed);
+        auto const t = top_.load(std::memory_order_relaxed);
+        return b > t ? b - t : 0;
+    }
+
+    [[nodiscard]] auto Empty() const noexcept -> bool { return Size() == 0; }
+
+private:
+    auto Grow(Array* a, std::int64_t t, std::int64_t b) -> Array*
+    {
+        auto bigger = std::make_unique<Array>(a->capacity * 2);
+        for (auto i = t; i != b; ++i)
+        {
+            bigger->Put(i, a->Get(i));
+        }
+
+        auto* raw = bigger.get();
+        arrays_.push_back(std::move(bigger));
+        array_.store(raw, std::memory_order_release);
+        return raw;
+    }
+
+    alignas(64) std::atomic<std::int64_t> top_ {0};
+    alignas(64) std::atomic<std::int64_t> bottom_ {0};
+    alignas(64) std::atomic<Array*> array_ {nullptr};
+    std::vector<std::unique_ptr<Array>> arrays_;
+};
+
+}  // namespace mc
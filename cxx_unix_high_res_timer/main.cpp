@@ -1,33 +1,41 @@
+#include "trace.hpp"
+
 #include <cmath>
+#include <cstdint>
 #include <cstdio>
-#include <sys/time.h>
+#include <cstdlib>
 
 class HighResolutionTimer {
 public:
-  explicit HighResolutionTimer() { gettimeofday(&startTime_, nullptr); }
+  explicit HighResolutionTimer(char const *name = "HighResolutionTimer")
+      : name_{name}, startTicks_{mc::TraceClock::StartTick()} {}
 
   ~HighResolutionTimer() {
-    timeval stopTime;
-    gettimeofday(&stopTime, nullptr);
+    auto const stopTicks = mc::TraceClock::Now();
 
-    // compute and print the elapsed time in millisec
-    // sec to ms
-    double const elapsedSec = (stopTime.tv_sec - startTime_.tv_sec) * 1000.0;
-    // us to ms
-    double const elapsedMs = (stopTime.tv_usec - startTime_.tv_usec) / 1000.0;
+    // No formatting while tracing, the trace flusher does that later.
+    if (mc::Tracer::Enabled()) {
+      mc::Tracer::Record(name_, startTicks_, stopTicks);
+      return;
+    }
 
-    printf("%ld us | ", (stopTime.tv_usec - startTime_.tv_usec));
-    printf("%.2f ms\n", elapsedSec + elapsedMs);
+    auto const elapsedNs = mc::TraceClock::ToNanoseconds(stopTicks - startTicks_);
+    printf("%.0f ns | ", elapsedNs);
+    printf("%.2f ms\n", elapsedNs / 1'000'000.0);
   }
 
 private:
-  timeval startTime_;
+  char const *name_;
+  std::uint64_t startTicks_;
 };
 
 int main() {
+  // MC_TRACE=trace.json writes a Chrome/Perfetto trace instead of printing.
+  auto const session = mc::TraceSession{std::getenv("MC_TRACE")};
+
   auto returnVal = 0.0;
   {
-    auto const timer = HighResolutionTimer{};
+    auto const timer = HighResolutionTimer{"sin loop"};
     // do something
     for (auto i = 0; i < 100'000; i++) {
       returnVal += std::sin(i);